@@ -0,0 +1,184 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/resource.h>
+
+#include "types.h"
+#include "context.h"
+#include "parser.h"
+#include "semantic.h"
+#include "optimize.h"
+#include "source.h"
+#include "gen.h"
+#include "transpiler/type_registry.h"
+#include "transpiler/token_registry.h"
+
+// phase timings for one .w file:
+//
+//   bench [--repeat N] input.w...
+//   bench --header
+//
+// lexing is measured on its own scanner; parse() then lexes again as it pulls
+// tokens, so the parse column includes lexing, as in a real compilation. each
+// phase reports the best of N runs. peak RSS is the process high-water mark,
+// so `make bench` runs one input per process.
+
+#define DEFAULT_REPEAT 3
+
+typedef struct {
+    double lex;
+    double parse;
+    double annotate;
+    double generate;
+} PhaseTimes;
+
+// ==================== internal helper functions ====================
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static long count_lines(const SourceFile* source) {
+    long lines = 0;
+    for (size_t i = 0; i < source->length; i++) {
+        if (source->data[i] == '\n') lines++;
+    }
+    if (source->length > 0 && source->data[source->length - 1] != '\n') lines++;
+    return lines;
+}
+
+static double lex_only(SourceFile* source) {
+    yyscan_t scanner;
+    if (yylex_init(&scanner) != 0) return -1;
+
+    double start = now_seconds();
+    source_attach_lexer(source, scanner);
+    YYSTYPE value;
+    while (yylex(&value, scanner) != 0) {
+    }
+    double elapsed = now_seconds() - start;
+
+    yylex_destroy(scanner);
+    return elapsed;
+}
+
+// one full compilation with a timestamp between phases; output goes to
+// /dev/null so only the emitter's write path is measured, not the disk
+static bool compile_once(SourceFile* source, const char* name, PhaseTimes* times) {
+    TranspilerContext* ctx = context_create(name);
+    if (!ctx) return false;
+
+    if (setjmp(ctx->abort_point) != 0) {
+        context_destroy(ctx);
+        return false;
+    }
+
+    double start = now_seconds();
+    source_attach_lexer(source, ctx->scanner);
+    ctx->token = yylex(&ctx->lval, ctx->scanner);
+    ctx->ast = parse();
+    double parsed = now_seconds();
+
+    if (!ctx->ast) {
+        context_destroy(ctx);
+        return false;
+    }
+
+    annotate_program(ctx->ast);
+    fold_program(ctx->ast);
+    // no dead function elimination: generated programs barely call their
+    // functions from w(), and the generate column should cover all of them
+    double annotated = now_seconds();
+
+    Emitter* output = emitter_open("/dev/null", EMITTER_BUFFERED);
+    if (!output) {
+        context_destroy(ctx);
+        return false;
+    }
+    generate_code(output, ctx->ast);
+    emitter_close(output);
+    double generated = now_seconds();
+
+    bool ok = ctx->parser_state.error_count == 0;
+    context_destroy(ctx);
+
+    times->parse = parsed - start;
+    times->annotate = annotated - parsed;
+    times->generate = generated - annotated;
+    return ok;
+}
+
+static double min_time(double best, double sample) {
+    return best < 0 || sample < best ? sample : best;
+}
+
+static void print_header(void) {
+    printf("%-36s %9s %9s %9s %9s %9s %12s %10s\n",
+           "input", "lines", "lex ms", "parse ms", "annot ms", "gen ms", "lines/s", "peak RSS");
+}
+
+static bool bench_file(const char* path, int repeat) {
+    SourceFile source;
+    if (!source_open(&source, path) || source.stream) {
+        fprintf(stderr, "%s: cannot map input\n", path);
+        if (source.stream) source_close(&source);
+        return false;
+    }
+
+    long lines = count_lines(&source);
+    PhaseTimes best = {-1, -1, -1, -1};
+    for (int i = 0; i < repeat; i++) {
+        PhaseTimes run;
+        run.lex = lex_only(&source);
+        if (run.lex < 0 || !compile_once(&source, path, &run)) {
+            fprintf(stderr, "%s: compilation failed\n", path);
+            source_close(&source);
+            return false;
+        }
+        best.lex = min_time(best.lex, run.lex);
+        best.parse = min_time(best.parse, run.parse);
+        best.annotate = min_time(best.annotate, run.annotate);
+        best.generate = min_time(best.generate, run.generate);
+    }
+    source_close(&source);
+
+    // throughput of a whole compilation; lexing is inside the parse column
+    double total = best.parse + best.annotate + best.generate;
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+
+    printf("%-36s %9ld %9.2f %9.2f %9.2f %9.2f %12.0f %7.1f MB\n",
+           path, lines, best.lex * 1e3, best.parse * 1e3, best.annotate * 1e3,
+           best.generate * 1e3, total > 0 ? (double)lines / total : 0.0,
+           (double)usage.ru_maxrss / 1024.0);
+    fflush(stdout);
+    return true;
+}
+
+// ==================== main ====================
+
+int main(int argc, char* argv[]) {
+    int repeat = DEFAULT_REPEAT;
+    int status = 0;
+
+    type_registry_init();
+    token_registry_init();
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--header") == 0) {
+            print_header();
+        } else if (strcmp(argv[i], "--repeat") == 0 && i + 1 < argc) {
+            repeat = atoi(argv[++i]);
+            if (repeat < 1) repeat = 1;
+        } else if (!bench_file(argv[i], repeat)) {
+            status = 1;
+        }
+    }
+
+    token_registry_cleanup();
+    type_registry_cleanup();
+    return status;
+}
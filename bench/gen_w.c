@@ -0,0 +1,236 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+
+// synthetic W program generator for the benchmark suite.
+//
+//   gen_w [--shape NAME] [--lines N] [--depth D] [--locals L] [--seed S]
+//
+// writes a valid program of roughly N lines to stdout. shapes:
+//   functions    many small functions calling each other
+//   expressions  long chains of deeply nested arithmetic (D levels)
+//   locals       functions with L local declarations each
+//   logs         log statements mixing strings, variables and numbers
+//   mixed        all of the above in rotation
+
+typedef enum {
+    SHAPE_FUNCTIONS,
+    SHAPE_EXPRESSIONS,
+    SHAPE_LOCALS,
+    SHAPE_LOGS,
+    SHAPE_MIXED
+} Shape;
+
+static const char* shape_names[] = {"functions", "expressions", "locals", "logs", "mixed"};
+
+typedef struct {
+    Shape shape;
+    long lines;
+    int depth;
+    int locals;
+    unsigned long seed;
+    long emitted;               // lines written so far
+    long functions;             // functions written so far
+} Generator;
+
+// ==================== internal helper functions ====================
+
+// xorshift, so every run with the same seed emits the same program
+static unsigned long next_random(Generator* gen) {
+    gen->seed ^= gen->seed << 13;
+    gen->seed ^= gen->seed >> 7;
+    gen->seed ^= gen->seed << 17;
+    return gen->seed;
+}
+
+static const char* random_operator(Generator* gen) {
+    static const char* operators[] = {" + ", " - ", " * ", " / "};
+    return operators[next_random(gen) % 4];
+}
+
+static void line(Generator* gen, const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+
+static void line(Generator* gen, const char* fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    vprintf(fmt, args);
+    va_end(args);
+    putchar('\n');
+    gen->emitted++;
+}
+
+static void blank_line(Generator* gen) {
+    putchar('\n');
+    gen->emitted++;
+}
+
+// statements per function body, so no single function grows without bound
+static long body_lines(Generator* gen, long wanted) {
+    long left = gen->lines - gen->emitted - 3;
+    if (left < 1) left = 1;
+    return wanted < left ? wanted : left;
+}
+
+// ==================== shapes ====================
+
+// fun fN(a: num, b: num): num { dec t: num = a * k + b; ret t - fN-1(b, a); }
+static void emit_small_function(Generator* gen) {
+    long id = gen->functions++;
+    line(gen, "fun f%ld(a: num, b: num): num {", id);
+    line(gen, "    dec t: num = a * %lu + b;", next_random(gen) % 97 + 1);
+    if (id > 0 && gen->shape == SHAPE_FUNCTIONS) {
+        line(gen, "    ret t - f%ld(b, a);", id - 1);
+    } else {
+        line(gen, "    ret t;");
+    }
+    line(gen, "}");
+    blank_line(gen);
+}
+
+// left-nested chain: ((((x + 3) * y) - v2) / 5)
+static void emit_nested_expression(Generator* gen, int depth, long previous) {
+    for (int i = 0; i < depth; i++) {
+        putchar('(');
+    }
+    fputs("x", stdout);
+    for (int i = 0; i < depth; i++) {
+        fputs(random_operator(gen), stdout);
+        switch (next_random(gen) % 3) {
+            case 0:  printf("%lu", next_random(gen) % 9 + 1); break;
+            case 1:  fputs("y", stdout); break;
+            default:
+                if (previous >= 0) printf("e%ld", previous);
+                else fputs("x", stdout);
+                break;
+        }
+        putchar(')');
+    }
+}
+
+static void emit_expression_function(Generator* gen) {
+    long id = gen->functions++;
+    long count = body_lines(gen, 64);
+
+    line(gen, "fun g%ld(x: num, y: num): num {", id);
+    for (long i = 0; i < count; i++) {
+        printf("    dec e%ld: num = ", i);
+        emit_nested_expression(gen, gen->depth, i - 1);
+        line(gen, ";");
+    }
+    line(gen, "    ret e%ld;", count - 1);
+    line(gen, "}");
+    blank_line(gen);
+}
+
+static void emit_locals_function(Generator* gen) {
+    long id = gen->functions++;
+    long end = gen->emitted + body_lines(gen, gen->locals);
+
+    line(gen, "fun h%ld(seed: num): real {", id);
+    line(gen, "    dec v0: num = seed;");
+    line(gen, "    dec r0: real = 0.5;");
+    long i = 1;
+    for (; gen->emitted < end; i++) {
+        switch (i % 4) {
+            case 0:  line(gen, "    dec v%ld: num = v%ld + %ld;", i, i - 1, i % 113); break;
+            case 1:  line(gen, "    dec r%ld: real = r%ld * 1.5;", i, i - 1); break;
+            case 2:  line(gen, "    dec c%ld: chr = 'w';", i); break;
+            default: line(gen, "    dec b%ld: bool = true;", i); break;
+        }
+        // keep the chains connected across the case rotation
+        if (i % 4 != 0) {
+            line(gen, "    dec v%ld: num = v%ld;", i, i - 1);
+        }
+        if (i % 4 != 1) {
+            line(gen, "    dec r%ld: real = r%ld;", i, i - 1);
+        }
+    }
+    line(gen, "    ret r%ld;", i - 1);
+    line(gen, "}");
+    blank_line(gen);
+}
+
+static void emit_log_function(Generator* gen) {
+    long id = gen->functions++;
+    long count = body_lines(gen, 64);
+
+    line(gen, "fun l%ld(count: num, name: str): zil {", id);
+    line(gen, "    dec total: num = count * 2;");
+    for (long i = 0; i < count; i++) {
+        switch (i % 3) {
+            case 0:  line(gen, "    log(\"item\", count, \"of\", total, name);"); break;
+            case 1:  line(gen, "    log(\"progress: \" + count, \"step\", %ld);", i); break;
+            default: line(gen, "    log(\"name = \" + name);"); break;
+        }
+    }
+    line(gen, "}");
+    blank_line(gen);
+}
+
+// ==================== main ====================
+
+static void usage(const char* program) {
+    fprintf(stderr, "Usage: %s [--shape functions|expressions|locals|logs|mixed] "
+                    "[--lines N] [--depth D] [--locals L] [--seed S]\n", program);
+}
+
+int main(int argc, char* argv[]) {
+    Generator gen = {
+        .shape = SHAPE_MIXED,
+        .lines = 1000,
+        .depth = 16,
+        .locals = 256,
+        .seed = 88172645463325252UL
+    };
+
+    for (int i = 1; i < argc; i++) {
+        const char* value = i + 1 < argc ? argv[i + 1] : NULL;
+        if (strcmp(argv[i], "--shape") == 0 && value) {
+            size_t count = sizeof(shape_names) / sizeof(shape_names[0]);
+            size_t s = 0;
+            while (s < count && strcmp(shape_names[s], value) != 0) s++;
+            if (s == count) {
+                usage(argv[0]);
+                return 1;
+            }
+            gen.shape = (Shape)s;
+        } else if (strcmp(argv[i], "--lines") == 0 && value) {
+            gen.lines = atol(value);
+        } else if (strcmp(argv[i], "--depth") == 0 && value) {
+            gen.depth = atoi(value);
+        } else if (strcmp(argv[i], "--locals") == 0 && value) {
+            gen.locals = atoi(value);
+        } else if (strcmp(argv[i], "--seed") == 0 && value) {
+            gen.seed = strtoul(value, NULL, 10) | 1;
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+        i++;
+    }
+    if (gen.lines < 1 || gen.depth < 1 || gen.locals < 2) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    // leave room for w()
+    while (gen.emitted < gen.lines - 4) {
+        Shape shape = gen.shape;
+        if (shape == SHAPE_MIXED) {
+            shape = (Shape)(gen.functions % SHAPE_MIXED);
+        }
+        switch (shape) {
+            case SHAPE_FUNCTIONS:   emit_small_function(&gen); break;
+            case SHAPE_EXPRESSIONS: emit_expression_function(&gen); break;
+            case SHAPE_LOCALS:      emit_locals_function(&gen); break;
+            default:                emit_log_function(&gen); break;
+        }
+    }
+
+    line(&gen, "fun w(): num {");
+    line(&gen, "    log(\"generated\", %ld, \"functions\");", gen.functions);
+    line(&gen, "    ret 0;");
+    line(&gen, "}");
+    return 0;
+}
@@ -1,6 +1,10 @@
 #ifndef AST_H
 #define AST_H
 
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
 #include "types.h"
 
 typedef struct {
@@ -15,8 +19,22 @@ typedef struct {
     DataType expr_type;
 } Expression;
 
+// how a function is declared in the generated C; decided by
+// plan_whole_program, extern (plain) otherwise
+typedef enum {
+    LINKAGE_EXTERN,
+    LINKAGE_STATIC,
+    LINKAGE_INLINE              // static inline
+} FunctionLinkage;
+
+typedef enum {
+    HOTNESS_NORMAL,
+    HOTNESS_HOT,                // __attribute__((hot))
+    HOTNESS_COLD                // __attribute__((cold))
+} FunctionHotness;
+
 typedef struct Parameter {
-    char* name;
+    const char* name;
     DataType type;
     struct Parameter* next;
 } Parameter;
@@ -30,16 +48,23 @@ typedef struct ASTNode {
             struct ASTNode* globals;
         } program;
         struct {
-            char* return_type;
-            char* name;
+            const char* return_type;
+            const char* name;
             Parameter* parameters;
             int param_count;
             struct ASTNode* body;
             int has_return;
+            uint64_t cache_key;         // content hash, set when a function cache is in use
+            const char* cached_code;    // generated C reused from the cache, or NULL
+            size_t cached_length;
+            FunctionLinkage linkage;
+            FunctionHotness hotness;
+            bool needs_prototype;       // called before its definition in the output
         } function;
         struct {
             Expression base;
-            char* target;
+            const char* target;
+            DataType target_type;     // declared type of the target variable
             struct ASTNode* value;
         } assignment;
         struct {
@@ -61,7 +86,7 @@ typedef struct ASTNode {
         } unary_expr;
         struct {
             Expression base;
-            char* name;
+            const char* name;
             struct ASTNode** args;    // array of argument expressions
             int arg_count;
         } function_call;
@@ -71,11 +96,11 @@ typedef struct ASTNode {
         } number;
         struct {
             Expression base;
-            char* value;
+            const char* value;
         } string;
         struct {
             Expression base;
-            char* name;
+            const char* name;
         } variable;
         struct {
             Expression base;
@@ -90,7 +115,7 @@ typedef struct ASTNode {
             bool value;
         } bool_val;
         struct {
-            char* name;
+            const char* name;
             DataType type;
             struct ASTNode* init_expr;
         } var_declaration;
@@ -98,27 +123,43 @@ typedef struct ASTNode {
     struct ASTNode* next;
 } ASTNode;
 
+// ==================== compilation arena ====================
+// every node, parameter, log element and identifier of a compilation lives in
+// one arena owned by the current context; identifiers are interned so equal
+// names share one pointer.
+
+bool init_ast(void);
+void* ast_alloc(size_t size);
+const char* ast_intern(const char* str);
+const char* ast_intern_len(const char* str, size_t len);
+
+// ==================== node construction ====================
+// names and string values passed to constructors must already be interned;
+// nodes keep the pointer rather than copying the text.
+
 ASTNode* create_unary_expr_node(char operator, ASTNode* operand, SourceLocation loc);
-ASTNode* create_function_call_node(char* name, ASTNode** args, int arg_count, SourceLocation loc);
+ASTNode* create_function_call_node(const char* name, ASTNode** args, int arg_count, SourceLocation loc);
 
 void set_node_location(ASTNode* node, SourceLocation loc);
 
 ASTNode* create_program_node(SourceLocation loc);
-ASTNode* create_function_node(char* return_type, char* name, Parameter* parameters, int param_count, ASTNode* body, int has_return, SourceLocation loc);
+ASTNode* create_function_node(const char* return_type, const char* name, Parameter* parameters, int param_count, ASTNode* body, int has_return, SourceLocation loc);
 ASTNode* create_log_node(LogElement* elements);
-ASTNode* create_assignment_node(char* name, ASTNode* value, SourceLocation loc);
+ASTNode* create_return_node(ASTNode* expression, SourceLocation loc);
+ASTNode* create_assignment_node(const char* name, ASTNode* value, SourceLocation loc);
 ASTNode* create_binary_expr_node(ASTNode* left, ASTNode* right, char operator, SourceLocation loc);
 ASTNode* create_number_node(int value, SourceLocation loc);
-ASTNode* create_string_node(char* value, SourceLocation loc);
-ASTNode* create_variable_node(char* name, SourceLocation loc);
+ASTNode* create_string_node(const char* value, SourceLocation loc);
+ASTNode* create_variable_node(const char* name, SourceLocation loc);
 ASTNode* create_float_node(double value, SourceLocation loc);
 ASTNode* create_char_node(char value, SourceLocation loc);
 ASTNode* create_bool_node(bool value, SourceLocation loc);
-ASTNode* create_var_declaration_node(char* name, DataType type, ASTNode* init_expr, SourceLocation loc);
+ASTNode* create_var_declaration_node(const char* name, DataType type, ASTNode* init_expr, SourceLocation loc);
 
-void free_log_elements(LogElement* elements);
-void free_ast(ASTNode* node);
+Parameter* create_parameter(const char* name, DataType type);
+LogElement* create_log_element(NodeType type);
 
-extern ASTNode* ast;
+// release the whole compilation arena (all nodes and interned strings)
+void free_ast(void);
 
 #endif
\ No newline at end of file
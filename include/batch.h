@@ -0,0 +1,18 @@
+#ifndef W_BATCH_H
+#define W_BATCH_H
+
+#include <stdbool.h>
+
+#include "context.h"
+
+// batch mode: transpile many files into one output directory on a pool of
+// worker threads. each input a/b/name.w becomes output_dir/name.c; callers
+// reject inputs sharing a name first (output_paths_distinct).
+
+// jobs <= 0 picks one worker per online CPU; diagnostics are always qualified
+// with the input name
+// returns: number of files that failed
+int transpile_batch(const char** inputs, int count, const char* output_dir,
+                    int jobs, const TranspileOptions* options);
+
+#endif
@@ -17,6 +17,10 @@
 #define C_FOR                 "for"
 #define C_TRUE                "true"
 #define C_FALSE               "false"
+#define C_STATIC              "static"
+#define C_INLINE              "inline"
+#define C_ATTRIBUTE_HOT       "__attribute__((hot))"
+#define C_ATTRIBUTE_COLD      "__attribute__((cold))"
 
 // ===== punctuation & delimiters =====
 #define C_LPAREN              "("
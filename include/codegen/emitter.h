@@ -0,0 +1,72 @@
+#ifndef EMITTER_H
+#define EMITTER_H
+
+#include <stddef.h>
+#include <stdbool.h>
+
+// output sink for code generation: text is appended to a large in-memory
+// buffer and handed to the OS in a few big writes instead of per-token stdio.
+
+typedef enum {
+    EMITTER_BUFFERED,   // growable buffer, flushed with write(2) when full
+    EMITTER_MMAP,       // output file is mapped and written in place
+    EMITTER_MEMORY      // no backing file; text stays in the buffer
+} EmitterMode;
+
+typedef struct {
+    char* data;         // buffer (or file mapping in EMITTER_MMAP mode)
+    size_t length;      // bytes not yet flushed (bytes written for mmap/memory)
+    size_t capacity;
+    size_t flushed;     // bytes already written out in buffered mode
+    int fd;             // -1 in memory mode
+    EmitterMode mode;
+    bool failed;        // sticky error flag, checked by emitter_close
+} Emitter;
+
+// ==================== lifecycle ====================
+
+// open (create/truncate) an output file
+// returns: emitter or NULL if the file cannot be opened
+Emitter* emitter_open(const char* path, EmitterMode mode);
+
+// create an emitter that only accumulates text in memory
+Emitter* emitter_create_memory(void);
+
+// drop everything written so far (memory mode), keeping the buffer for reuse
+void emitter_reset(Emitter* out);
+
+// write any buffered text to the file (no-op for mmap and memory modes)
+bool emitter_flush(Emitter* out);
+
+// flush, close the file and free the emitter
+// returns: false if any write failed
+bool emitter_close(Emitter* out);
+
+// ==================== writing ====================
+
+// append len raw bytes
+void emit_raw(Emitter* out, const char* data, size_t len);
+
+// append a NUL-terminated string
+void emit_str(Emitter* out, const char* str);
+
+// append a string literal without measuring it at runtime
+#define emit_lit(out, lit) emit_raw((out), (lit), sizeof(lit) - 1)
+
+// append a single character
+void emit_char(Emitter* out, char c);
+
+// append a decimal integer
+void emit_int(Emitter* out, int value);
+
+// append printf-formatted text (for the few cases that need it, e.g. floats)
+void emit_format(Emitter* out, const char* fmt, ...);
+
+// emit indentation (level * 4 spaces) from a precomputed string
+void emit_indent(Emitter* out, int level);
+
+// append str with C string-literal escaping applied; unescaped runs are
+// copied in bulk
+void emit_escaped(Emitter* out, const char* str);
+
+#endif // EMITTER_H
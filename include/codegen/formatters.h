@@ -1,32 +1,39 @@
 #ifndef FORMATTERS_H
 #define FORMATTERS_H
 
-#include <stdio.h>
 #include "types.h"
 #include "ast.h"
+#include "codegen/emitter.h"
 
-// ==================== output helpers ====================
+// ==================== identifiers ====================
+
+// emit the C spelling of a W Lang name (w() becomes main, everything else is
+// mangled to W__name_f / W__name_v)
+void emit_identifier(Emitter* out, const char* w_name, bool is_function);
 
-// emit indentation (level * 4 spaces)
-void emit_indent(FILE* out, int level);
+// ==================== output helpers ====================
 
 // emit standard C includes block
-void emit_c_includes(FILE* out);
+void emit_c_includes(Emitter* out);
 
 // ==================== function generation ====================
 
-// emit complete function signature with parameters
-void emit_function_signature(FILE* out, const char* return_type, const char* name,
+// emit complete function signature with parameters; name is the W Lang name
+void emit_function_signature(Emitter* out, const char* return_type, const char* name,
                              Parameter* params, int param_count);
 
+// emit the storage class and attributes that precede a function's signature
+// (nothing for extern functions)
+void emit_function_linkage(Emitter* out, const ASTNode* function);
+
 // emit function forward declaration (signature + semicolon)
-void emit_function_declaration(FILE* out, const char* return_type, const char* name,
+void emit_function_declaration(Emitter* out, const char* return_type, const char* name,
                                 Parameter* params, int param_count);
 
 // ==================== type conversion ====================
 
 // emit type cast if needed (handles conversion rules)
-void emit_cast(FILE* out, DataType from_type, DataType to_type);
+void emit_cast(Emitter* out, DataType from_type, DataType to_type);
 
 // ==================== operator formatting ====================
 
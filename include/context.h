@@ -0,0 +1,95 @@
+#ifndef W_CONTEXT_H
+#define W_CONTEXT_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <setjmp.h>
+
+#include "types.h"
+#include "ast.h"
+#include "symbol_table.h"
+#include "source.h"
+#include "codegen/emitter.h"
+#include "data_structures/arena.h"
+#include "data_structures/string_intern.h"
+#include "transpiler/function_cache.h"
+
+// everything one compilation needs: scanner, parser state, scopes, AST arena.
+// each thread works on its own context, so any number of files can be
+// transpiled at once; the type and token registries are shared read-only.
+typedef struct TranspilerContext {
+    yyscan_t scanner;
+    YYSTYPE lval;                   // semantic value of the current token
+    TokenType token;                // current lookahead token
+    double lex_seconds;             // time inside yylex, with --time-report
+
+    ParserState parser_state;
+    SymbolTable* symbol_table;
+    FunctionTable* function_table;
+
+    Arena* arena;                   // AST nodes and interned identifiers
+    StringInterner* strings;
+    ASTNode* ast;
+
+    FunctionCache* cache;           // NULL when caching is off
+    Emitter* scratch;               // functions are generated here before caching
+
+    const char* input_name;
+    FILE* diagnostics;              // where errors are reported (stderr by default)
+    bool qualify_errors;            // prefix diagnostics with input_name
+    bool report_removed;            // note each function dropped as unreachable
+    bool whole_program;             // static linkage and callee-first order
+    bool hot_cold;                  // hot/cold attributes (whole-program only)
+    jmp_buf abort_point;            // fatal errors unwind to context_run
+} TranspilerContext;
+
+// how transpile_file writes and reports
+typedef struct {
+    EmitterMode mode;
+    bool qualify_errors;            // prefix diagnostics with the input name
+    const char* cache_dir;          // function cache directory, or NULL
+    bool report_removed;            // note each function dropped as unreachable
+    bool whole_program;             // static linkage and callee-first order
+    bool hot_cold;                  // also emit hot/cold attributes; implies whole_program
+} TranspileOptions;
+
+// ==================== lifecycle ====================
+
+// create a context and make it the calling thread's current context
+// returns: context or NULL if the scanner or arena cannot be set up
+TranspilerContext* context_create(const char* input_name);
+
+// apply per-run options (error prefixes, function cache)
+void context_configure(TranspilerContext* ctx, const TranspileOptions* options);
+
+// drop the previous compilation's AST, scopes and scanner state but keep the
+// allocations, so a long-lived context can take the next input cheaply
+void context_reset(TranspilerContext* ctx, const char* input_name);
+
+// release everything owned by the context
+void context_destroy(TranspilerContext* ctx);
+
+// context of the compilation running on the calling thread
+TranspilerContext* current_context(void);
+
+// line the scanner is on, for locations and diagnostics
+int context_line(TranspilerContext* ctx);
+
+// read the next token into ctx->token and ctx->lval
+void context_advance(TranspilerContext* ctx);
+
+// abandon the current compilation; control returns to context_run
+void context_abort(TranspilerContext* ctx);
+
+// ==================== driver ====================
+
+// lex, parse, annotate and generate one source into output
+// returns: false on any error; diagnostics go to ctx->diagnostics
+bool context_run(TranspilerContext* ctx, SourceFile* input, Emitter* output);
+
+// transpile one .w file into one .c file on the calling thread
+// returns: false on any error; a failed compilation leaves no output file
+bool transpile_file(const char* input_name, const char* output_name,
+                    const TranspileOptions* options);
+
+#endif
@@ -0,0 +1,65 @@
+#ifndef W_DAEMON_PROTOCOL_H
+#define W_DAEMON_PROTOCOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// wire format between transpiler-client and `transpiler --serve`. both ends
+// run on one host over a UNIX socket, so integers are sent in native order.
+// a connection carries any number of request/response pairs:
+//
+//   request:  RequestHeader, input name (name_length bytes), source bytes
+//   response: ResponseHeader, generated C, diagnostics text
+
+#define PROTOCOL_MAGIC 0x574c4e47u          // "WLNG"
+#define PROTOCOL_VERSION 1
+
+#define PROTOCOL_MAX_NAME 4096
+#define PROTOCOL_MAX_SOURCE (256u << 20)
+
+// environment variable naming the server socket for the client
+#define PROTOCOL_SOCKET_ENV "WLANG_SERVER"
+
+typedef enum {
+    REQUEST_QUALIFY_ERRORS = 1 << 0,    // prefix diagnostics with the input name
+    REQUEST_REPORT_REMOVED = 1 << 1,    // note functions dropped as unreachable
+    REQUEST_WHOLE_PROGRAM = 1 << 2,     // static linkage and callee-first order
+    REQUEST_HOT_COLD = 1 << 3           // hot/cold attributes
+} RequestFlags;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t flags;
+    uint32_t name_length;
+    uint64_t source_length;
+} RequestHeader;
+
+typedef enum {
+    RESPONSE_OK = 0,
+    RESPONSE_FAILED = 1,                // compile errors; see diagnostics
+    RESPONSE_BAD_REQUEST = 2
+} ResponseStatus;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t status;
+    uint64_t output_length;
+    uint64_t diagnostics_length;
+} ResponseHeader;
+
+// ==================== I/O helpers ====================
+
+// read exactly len bytes, retrying on short reads and EINTR
+// returns: false on error or end of stream
+bool protocol_read_all(int fd, void* data, size_t len);
+
+// write exactly len bytes, retrying on short writes and EINTR
+bool protocol_write_all(int fd, const void* data, size_t len);
+
+// connect to a server socket
+// returns: connected fd or -1 (errno set)
+int protocol_connect(const char* socket_path);
+
+#endif
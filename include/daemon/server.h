@@ -0,0 +1,17 @@
+#ifndef W_DAEMON_SERVER_H
+#define W_DAEMON_SERVER_H
+
+#include <stdbool.h>
+
+#include "context.h"
+
+// daemon mode: keep one warm process answering transpile requests on a UNIX
+// socket (see daemon/protocol.h). each connection is served by its own thread
+// and reuses one context, reset between requests. the registries must be
+// initialized before calling.
+
+// serve until SIGINT or SIGTERM, then remove the socket
+// returns: false if the socket cannot be set up
+bool serve(const char* socket_path, const TranspileOptions* options);
+
+#endif
@@ -0,0 +1,49 @@
+#ifndef WLANG_ARENA_H
+#define WLANG_ARENA_H
+
+#include <stddef.h>
+
+// bump allocator: memory is carved out of large chunks and released all at once.
+// individual allocations are never freed.
+
+typedef struct ArenaChunk ArenaChunk;
+
+struct ArenaChunk {
+    ArenaChunk* next;           // previously filled chunk
+    size_t capacity;            // usable bytes in data[]
+    size_t used;                // bytes handed out so far
+    unsigned char data[];
+};
+
+typedef struct {
+    ArenaChunk* head;           // chunk currently being filled
+    size_t chunk_size;          // default size for new chunks
+    size_t total_allocated;     // bytes handed out across all chunks
+} Arena;
+
+// ==================== core API ====================
+
+// create an arena; chunk_size of 0 selects the default (64 KiB)
+Arena* arena_create(size_t chunk_size);
+
+// allocate size bytes aligned for any object type
+// returns: pointer into the arena or NULL on allocation failure
+void* arena_alloc(Arena* arena, size_t size);
+
+// allocate zero-initialized memory
+void* arena_calloc(Arena* arena, size_t count, size_t size);
+
+// copy len bytes of str into the arena and NUL-terminate the copy
+char* arena_strndup(Arena* arena, const char* str, size_t len);
+
+// release every chunk but keep the arena usable
+void arena_reset(Arena* arena);
+
+// forget every allocation but keep the newest chunk for reuse, so an arena
+// recycled between compilations rarely goes back to malloc
+void arena_rewind(Arena* arena);
+
+// release every chunk and the arena itself
+void arena_destroy(Arena* arena);
+
+#endif // WLANG_ARENA_H
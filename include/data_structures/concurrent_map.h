@@ -0,0 +1,71 @@
+#ifndef WLANG_CONCURRENT_MAP_H
+#define WLANG_CONCURRENT_MAP_H
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+#include "data_structures/map.h"
+
+// thread-safe map: a power-of-two number of Maps (shards), each behind its
+// own reader-writer lock. the top bits of a key's hash pick the shard, the
+// rest place it inside, so the key is hashed once. readers of one shard run
+// in parallel (map_get never writes, see map.h); writers only block their
+// own shard.
+//
+// values are returned by copy of the stored pointer: payloads the map copied
+// (key_size/value_size, key_copy/value_copy) may be replaced or freed by
+// another thread once the call returns, so keep such maps to integer values
+// or use cmap_upsert to work on a value under the lock.
+
+#define CMAP_DEFAULT_SHARDS 16
+
+typedef struct {
+    pthread_rwlock_t lock;
+    Map* map;
+} __attribute__((aligned(64))) CMapShard;    // one cache line each, no false sharing
+
+typedef struct {
+    CMapShard* shards;
+    size_t shard_count;         // a power of two
+    unsigned shard_shift;       // 64 - log2(shard_count)
+} ConcurrentMap;
+
+// ==================== core API ====================
+
+// create a map of shard_count shards (rounded up to a power of two; 0 picks
+// CMAP_DEFAULT_SHARDS) with room for about initial_capacity entries in all
+ConcurrentMap* cmap_create(size_t shard_count, size_t initial_capacity, MapConfig config);
+
+// insert or update a key-value pair
+// returns: true if new entry, false if updated existing
+bool cmap_put(ConcurrentMap* cmap, void* key, void* value);
+
+// retrieve a value by key
+// returns: value pointer or NULL if not found
+void* cmap_get(ConcurrentMap* cmap, const void* key);
+
+// like cmap_get, but tells a stored NULL (integer 0) from an absent key
+// returns: true and the value in *value_out if found
+bool cmap_lookup(ConcurrentMap* cmap, const void* key, void** value_out);
+
+bool cmap_contains(ConcurrentMap* cmap, const void* key);
+
+// returns: true if found and removed, false otherwise
+bool cmap_remove(ConcurrentMap* cmap, const void* key);
+
+// map_upsert under the shard's write lock: an atomic read-modify-write.
+// same rule as map_upsert: only for maps that store values as given
+// returns: false if the insert failed
+bool cmap_upsert(ConcurrentMap* cmap, void* key, MapUpsertFunc update, void* context);
+
+// sum of the shard sizes; exact only while no other thread writes
+size_t cmap_size(ConcurrentMap* cmap);
+
+// clear every shard, one at a time
+void cmap_clear(ConcurrentMap* cmap);
+
+// destroy the map; no other thread may still use it
+void cmap_destroy(ConcurrentMap* cmap);
+
+#endif // WLANG_CONCURRENT_MAP_H
@@ -0,0 +1,101 @@
+#ifndef WLANG_HASH_H
+#define WLANG_HASH_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// seeded hashing shared by Map and the typed maps: wyhash for byte strings
+// (eight bytes per step) and one folded 64x64->128 multiply for integers.
+// every hash depends on hash_seed, so inputs crafted to collide in one run
+// do not collide in the next.
+
+#define HASH_P0 0xa0761d6478bd642fULL
+#define HASH_P1 0xe7037ed1a0b428dbULL
+#define HASH_P2 0x8ebc6af09c88c6e3ULL
+#define HASH_P3 0x589965cc75374cc3ULL
+
+// fixed until hash_seed_init runs, so a program that never calls it hashes
+// the same way every run
+extern uint64_t hash_seed;
+
+// pick a random seed. call once at startup, before any map exists: entries
+// already stored were placed with the old seed.
+void hash_seed_init(void);
+
+// ==================== primitives ====================
+
+// multiply to 128 bits and fold the halves together
+static inline uint64_t hash_mix(uint64_t a, uint64_t b) {
+    __uint128_t product = (__uint128_t)a * b;
+    return (uint64_t)product ^ (uint64_t)(product >> 64);
+}
+
+static inline uint64_t hash_read64(const uint8_t* p) {
+    uint64_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+static inline uint64_t hash_read32(const uint8_t* p) {
+    uint32_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+// ==================== hash functions ====================
+
+static inline uint64_t hash_u64(uint64_t key) {
+    return hash_mix(key ^ hash_seed ^ HASH_P0, key ^ HASH_P1);
+}
+
+static inline uint64_t hash_bytes(const void* data, size_t length) {
+    const uint8_t* p = data;
+    uint64_t seed = hash_seed;
+    uint64_t a, b;
+
+    if (length <= 16) {
+        if (length >= 4) {
+            // two overlapping reads cover 4..16 bytes without a loop
+            size_t middle = (length >> 3) << 2;
+            a = (hash_read32(p) << 32) | hash_read32(p + middle);
+            b = (hash_read32(p + length - 4) << 32) | hash_read32(p + length - 4 - middle);
+        } else if (length > 0) {
+            a = ((uint64_t)p[0] << 16) | ((uint64_t)p[length >> 1] << 8) | p[length - 1];
+            b = 0;
+        } else {
+            a = b = 0;
+        }
+    } else {
+        size_t left = length;
+        if (left > 48) {
+            // three independent lanes keep the multipliers busy
+            uint64_t lane1 = seed, lane2 = seed;
+            do {
+                seed = hash_mix(hash_read64(p) ^ HASH_P1, hash_read64(p + 8) ^ seed);
+                lane1 = hash_mix(hash_read64(p + 16) ^ HASH_P2, hash_read64(p + 24) ^ lane1);
+                lane2 = hash_mix(hash_read64(p + 32) ^ HASH_P3, hash_read64(p + 40) ^ lane2);
+                p += 48;
+                left -= 48;
+            } while (left > 48);
+            seed ^= lane1 ^ lane2;
+        }
+        while (left > 16) {
+            seed = hash_mix(hash_read64(p) ^ HASH_P1, hash_read64(p + 8) ^ seed);
+            p += 16;
+            left -= 16;
+        }
+        // the last 16 bytes, overlapping what came before
+        a = hash_read64(p + left - 16);
+        b = hash_read64(p + left - 8);
+    }
+
+    __uint128_t product = (__uint128_t)(a ^ HASH_P1) * (b ^ seed);
+    return hash_mix((uint64_t)product ^ HASH_P0 ^ length, (uint64_t)(product >> 64) ^ HASH_P1);
+}
+
+static inline uint64_t hash_cstring(const char* str) {
+    return hash_bytes(str, strlen(str));
+}
+
+#endif // WLANG_HASH_H
@@ -3,6 +3,13 @@
 
 #include <stddef.h>
 #include <stdbool.h>
+#include <stdint.h>
+
+#include "data_structures/map_group.h"
+#include "data_structures/arena.h"
+
+// entries a map keeps inline, before it has a table
+#define MAP_SMALL_CAPACITY 8
 
 // forward declarations
 typedef struct MapEntry MapEntry;
@@ -15,12 +22,13 @@ typedef void (*KeyFreeFunc)(void* key);
 typedef void (*ValueFreeFunc)(void* value);
 typedef void* (*KeyCopyFunc)(const void* key);
 typedef void* (*ValueCopyFunc)(const void* value);
+typedef size_t (*PayloadSizeFunc)(const void* payload);
 
-// entry in the hash map (linked list node for collision resolution)
+// slot in the hash map; entries live inline in the table
 struct MapEntry {
     void* key;
     void* value;
-    MapEntry* next;  // for collision chaining
+    uint64_t hash;              // mixed hash of key: resizes never call the hash function
 };
 
 // hash map configuration
@@ -31,20 +39,62 @@ typedef struct {
     ValueCopyFunc value_copy;   // optional: if NULL, stores pointer directly
     KeyFreeFunc key_free;       // optional: cleanup function for keys
     ValueFreeFunc value_free;   // optional: cleanup function for values
+    PayloadSizeFunc key_size;   // optional: copy key bytes into the map's payload arena
+    PayloadSizeFunc value_size; // optional: copy value bytes into the payload arena
+    bool incremental;           // optional: spread resizes over later puts and removes
 } MapConfig;
 
-// main hash map structure
+// keys and values with a size function are copied into an arena owned by the
+// map instead of going through copy/free callbacks: no malloc or free per
+// entry, and map_clear/map_destroy release them all at once. a value that is
+// replaced by one no larger reuses its bytes; otherwise the bytes of removed
+// or replaced payloads are only reclaimed by map_clear or map_destroy.
+
+// an incremental map does not move its entries when it grows: it allocates
+// the new table and keeps the old one, and every later put or remove moves a
+// few old slots across until the old table is empty. lookups check both
+// tables meanwhile. map_get and map_contains never move anything, so a map
+// that is only read may be shared between threads.
+
+// a map created for at most MAP_SMALL_CAPACITY entries starts without a
+// table: its entries sit in the header and a lookup compares their stored
+// hashes one after another. the put that would overflow them moves them into
+// a table, which the map then keeps. most maps (block scopes, small runtime
+// maps) never allocate anything but the header.
+
+// main hash map structure: a Swiss-table-style open-addressing table probed a
+// group of control bytes at a time (see map_group.h). the control array is
+// followed by a copy of its first MAP_GROUP_WIDTH - 1 bytes, so a group can be
+// loaded at any slot without wrapping.
 struct Map {
-    MapEntry** buckets;         // array of bucket heads
-    size_t bucket_count;        // number of buckets
+    MapEntry* entries;          // capacity slots; NULL while the map is small
+    int8_t* ctrl;               // capacity + MAP_GROUP_WIDTH - 1 control bytes
+    size_t capacity;            // number of slots, a power of two (0 while small)
     size_t size;                // number of entries
-    float load_factor;          // threshold for resizing (default 0.75)
+    size_t growth_left;         // inserts into empty slots before the next rehash
     MapConfig config;           // configuration with function pointers
+    Arena* payloads;            // copied keys and values, created on first use
+    MapEntry* old_entries;      // table being drained, NULL when no resize is running
+    int8_t* old_ctrl;
+    size_t old_capacity;        // 0 when no resize is running
+    size_t migrated;            // old slots already moved to the current table
+    MapEntry small[MAP_SMALL_CAPACITY];  // the first size entries while small, unordered
 };
 
+// optional allocation counter for Map, OrderedMap and ConcurrentMap: called
+// with the bytes of every table, header and copied payload. NULL by default,
+// so the library needs nothing outside data_structures; the transpiler
+// installs one under --mem-report, before any map exists.
+typedef void (*MapAllocHook)(size_t bytes);
+extern MapAllocHook map_alloc_hook;
+
+static inline void map_count_alloc(size_t bytes) {
+    if (map_alloc_hook) map_alloc_hook(bytes);
+}
+
 // ==================== core API ====================
 
-// create a new map with specified configuration
+// create a new map with room for about initial_capacity entries
 Map* map_create(size_t initial_capacity, MapConfig config);
 
 // insert or update a key-value pair
@@ -62,6 +112,11 @@ bool map_contains(const Map* map, const void* key);
 // returns: true if found and removed, false otherwise
 bool map_remove(Map* map, const void* key);
 
+// make room for count entries, so that no put grows the map until it holds
+// more than that; finishes any resize in progress
+// returns: false if the table could not be allocated
+bool map_reserve(Map* map, size_t count);
+
 // get the number of entries
 size_t map_size(const Map* map);
 
@@ -74,12 +129,66 @@ void map_clear(Map* map);
 // destroy the map and free all resources
 void map_destroy(Map* map);
 
+// ==================== entry API ====================
+// one hash and one probe per call. an entry stays valid until the map is
+// next changed; its value may be written through entry->value directly
+// when the map stores values as given.
+
+// updates the value of key in place; found is false for a key that was just
+// inserted with a NULL (integer 0) value
+typedef void (*MapUpsertFunc)(void** value, bool found, void* context);
+
+// the entry of key, or NULL; unlike map_get, tells a stored NULL from absent
+MapEntry* map_find(const Map* map, const void* key);
+
+// the entry of key, inserting key with value first if it is absent
+// returns: the entry, or NULL if the insert failed; *inserted (if not NULL)
+// says whether value was used
+MapEntry* map_get_or_insert(Map* map, void* key, void* value, bool* inserted);
+
+// run update on the value of key, inserting key first if it is absent; only
+// for maps that store values as given (no value_copy, value_size or value_free)
+// returns: false if the insert failed
+bool map_upsert(Map* map, void* key, MapUpsertFunc update, void* context);
+
+// ==================== prehashed API ====================
+// the same operations with the hash computed once by the caller, e.g. to
+// pick one of several maps first (see concurrent_map.h). the hash must come
+// from map_hash_key on a map with the same hash function.
+
+uint64_t map_hash_key(const Map* map, const void* key);
+bool map_put_hashed(Map* map, void* key, void* value, uint64_t hash);
+MapEntry* map_find_hashed(const Map* map, const void* key, uint64_t hash);
+bool map_remove_hashed(Map* map, const void* key, uint64_t hash);
+MapEntry* map_get_or_insert_hashed(Map* map, void* key, void* value, bool* inserted,
+                                   uint64_t hash);
+
+// ==================== batch API ====================
+// the keys of each block of 16 are hashed and their probes prefetched before
+// any is resolved, so the cache misses of a block overlap instead of
+// following one another. same results as one call per key, in order. worth
+// it once the table no longer fits in cache; below that it is slightly slower.
+
+// entries_out[i] is the entry of keys[i], or NULL
+// returns: number of keys found
+size_t map_find_many(const Map* map, const void* const* keys, size_t count,
+                     MapEntry** entries_out);
+
+// values_out[i] is the value of keys[i], or NULL
+// returns: number of keys found
+size_t map_get_many(const Map* map, const void* const* keys, size_t count, void** values_out);
+
+// put keys[i] -> values[i] for every i
+// returns: number of new entries
+size_t map_put_many(Map* map, void* const* keys, void* const* values, size_t count);
+
 // ==================== iteration API ====================
 
+// visits entries in slot order, those still in the old table of a running
+// resize first; the map must not change during iteration
 typedef struct {
     const Map* map;
-    size_t bucket_index;
-    MapEntry* current_entry;
+    size_t index;               // next slot: old table, then current table
 } MapIterator;
 
 // initialize iterator
@@ -93,6 +202,8 @@ bool map_iterator_next(MapIterator* iter, void** key_out, void** value_out);
 
 // ==================== built-in hash functions ====================
 
+// the hashes of values are seeded (see data_structures/hash.h)
+
 // hash function for integer keys (num type)
 unsigned long hash_int(const void* key);
 
@@ -102,10 +213,10 @@ unsigned long hash_float(const void* key);
 // hash function for char keys (chr type)
 unsigned long hash_char(const void* key);
 
-// hash function for string keys (str type) - FNV-1a algorithm
+// hash function for string keys (str type) - wyhash, eight bytes per step
 unsigned long hash_string(const void* key);
 
-// hash function for pointer addresses
+// hash function for pointer addresses; unseeded, the map mixes it
 unsigned long hash_pointer(const void* key);
 
 // ==================== built-in equality functions ====================
@@ -122,6 +233,14 @@ bool key_equal_pointer(const void* k1, const void* k2);
 void* key_copy_string(const void* key);
 void* value_copy_string(const void* value);
 
+// ==================== built-in payload sizes ====================
+
+// bytes of a NUL-terminated string, terminator included
+size_t payload_size_string(const void* payload);
+
+// bytes of a float (real type)
+size_t payload_size_float(const void* payload);
+
 // ==================== built-in free functions ====================
 
 // free function for strings
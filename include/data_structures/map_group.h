@@ -0,0 +1,96 @@
+#ifndef WLANG_MAP_GROUP_H
+#define WLANG_MAP_GROUP_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// control-byte groups shared by the generic Map and the typed maps of
+// typed_map.h. every slot has one control byte: empty, deleted, or the low 7
+// bits of its key's hash. a lookup compares a whole group of control bytes at
+// once and only looks at the entries whose byte matches.
+
+#define MAP_GROUP_WIDTH 16
+
+#define MAP_CTRL_EMPTY ((int8_t)-128)
+#define MAP_CTRL_DELETED ((int8_t)-2)
+
+// one bit per slot of a group, lowest bit first
+typedef uint32_t MapGroupMask;
+
+// spread every bit of a hash over the word; hashes may be weak in their low
+// bits (hash_pointer is the address) and both halves are used
+static inline uint64_t map_mix_hash(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    return h;
+}
+
+// the high bits choose where probing starts, the low 7 are kept in ctrl
+static inline size_t map_hash_position(uint64_t hash) {
+    return (size_t)(hash >> 7);
+}
+
+static inline int8_t map_hash_tag(uint64_t hash) {
+    return (int8_t)(hash & 0x7f);
+}
+
+// most entries a table of this capacity takes before growing (7/8 full)
+static inline size_t map_max_load(size_t capacity) {
+    return capacity - capacity / 8;
+}
+
+#ifdef __SSE2__
+
+static inline MapGroupMask map_group_match(const int8_t* group, int8_t tag) {
+    __m128i ctrl = _mm_loadu_si128((const __m128i*)group);
+    return (MapGroupMask)_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8(tag)));
+}
+
+// empty and deleted are the only control bytes with the sign bit set
+static inline MapGroupMask map_group_match_free(const int8_t* group) {
+    return (MapGroupMask)_mm_movemask_epi8(_mm_loadu_si128((const __m128i*)group));
+}
+
+#else
+
+static inline MapGroupMask map_group_match(const int8_t* group, int8_t tag) {
+    MapGroupMask mask = 0;
+    for (int i = 0; i < MAP_GROUP_WIDTH; i++) {
+        if (group[i] == tag) mask |= (MapGroupMask)1 << i;
+    }
+    return mask;
+}
+
+static inline MapGroupMask map_group_match_free(const int8_t* group) {
+    MapGroupMask mask = 0;
+    for (int i = 0; i < MAP_GROUP_WIDTH; i++) {
+        if (group[i] < 0) mask |= (MapGroupMask)1 << i;
+    }
+    return mask;
+}
+
+#endif
+
+static inline MapGroupMask map_group_match_empty(const int8_t* group) {
+    return map_group_match(group, MAP_CTRL_EMPTY);
+}
+
+// whether a removed slot can go back to empty instead of becoming a
+// tombstone: true when no group window covering it was ever full, because
+// then no probe sequence continued past it
+static inline int map_slot_never_full(const int8_t* ctrl, size_t index, size_t mask) {
+    MapGroupMask empty_after = map_group_match_empty(ctrl + index);
+    MapGroupMask empty_before = map_group_match_empty(ctrl + ((index - MAP_GROUP_WIDTH) & mask));
+    int free_after = empty_after ? __builtin_ctz(empty_after) : MAP_GROUP_WIDTH;
+    int free_before = empty_before
+        ? __builtin_clz(empty_before) - (int)(sizeof(MapGroupMask) * 8 - MAP_GROUP_WIDTH)
+        : MAP_GROUP_WIDTH;
+    return free_before + free_after < MAP_GROUP_WIDTH;
+}
+
+#endif
@@ -0,0 +1,77 @@
+#ifndef WLANG_ORDERED_MAP_H
+#define WLANG_ORDERED_MAP_H
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "data_structures/map.h"
+
+// insertion-ordered map in the compact layout of Python's dict: entries live
+// in one dense array in the order they were first put, and a Swiss-style
+// index (control bytes plus a 32-bit entry number per slot) finds them.
+// iteration is a linear scan of the dense array, in a deterministic order,
+// and costs the number of entries rather than the table size.
+//
+// takes the same MapConfig as Map; incremental is ignored. removing leaves a
+// hole in the dense array until holes outnumber entries, when the array is
+// compacted.
+
+typedef struct {
+    void* key;
+    void* value;
+    uint64_t hash;              // mixed hash of key, so rebuilding the index never rehashes
+    bool live;                  // false once removed
+} OrderedEntry;
+
+typedef struct {
+    OrderedEntry* entries;      // dense, in insertion order
+    size_t count;               // entries used, holes included
+    size_t entries_capacity;
+    int8_t* ctrl;               // capacity + MAP_GROUP_WIDTH - 1 control bytes
+    uint32_t* slots;            // entry number of each full slot
+    size_t capacity;            // index slots, a power of two
+    size_t growth_left;         // inserts into empty slots before the index is rebuilt
+    size_t size;                // live entries
+    MapConfig config;
+    Arena* payloads;            // copied keys and values, created on first use
+} OrderedMap;
+
+// ==================== core API ====================
+
+// create a map with room for about initial_capacity entries
+OrderedMap* omap_create(size_t initial_capacity, MapConfig config);
+
+// insert at the end, or update in place; an updated key keeps its position
+// returns: true if new entry, false if updated existing
+bool omap_put(OrderedMap* map, void* key, void* value);
+
+// returns: value pointer or NULL if not found
+void* omap_get(const OrderedMap* map, const void* key);
+
+bool omap_contains(const OrderedMap* map, const void* key);
+
+// returns: true if found and removed, false otherwise
+bool omap_remove(OrderedMap* map, const void* key);
+
+size_t omap_size(const OrderedMap* map);
+
+// clear all entries (calls free functions if provided)
+void omap_clear(OrderedMap* map);
+
+void omap_destroy(OrderedMap* map);
+
+// ==================== iteration API ====================
+
+// visits entries in insertion order; the map must not change during iteration
+typedef struct {
+    const OrderedMap* map;
+    size_t index;               // next entry of the dense array
+} OrderedMapIterator;
+
+OrderedMapIterator omap_iterator(const OrderedMap* map);
+
+// get next entry (returns false if no more entries)
+bool omap_iterator_next(OrderedMapIterator* iter, void** key_out, void** value_out);
+
+#endif // WLANG_ORDERED_MAP_H
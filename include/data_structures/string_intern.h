@@ -0,0 +1,47 @@
+#ifndef WLANG_STRING_INTERN_H
+#define WLANG_STRING_INTERN_H
+
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "data_structures/arena.h"
+
+// string interning: every distinct string is stored once in an arena,
+// so interned strings can be compared by pointer.
+
+typedef struct {
+    const char* str;            // interned copy (NULL for empty slot)
+    size_t length;
+    unsigned long hash;
+} InternSlot;
+
+typedef struct {
+    InternSlot* slots;          // open-addressed table, power-of-two sized
+    size_t capacity;
+    size_t size;
+    Arena* arena;               // owns the string bytes (not the table)
+} StringInterner;
+
+// ==================== core API ====================
+
+// create an interner that stores its strings in the given arena
+StringInterner* string_interner_create(Arena* arena);
+
+// intern a NUL-terminated string
+// returns: canonical pointer, identical for equal strings
+const char* string_intern(StringInterner* interner, const char* str);
+
+// intern len bytes starting at str (str need not be NUL-terminated)
+const char* string_intern_len(StringInterner* interner, const char* str, size_t len);
+
+// number of distinct strings interned
+size_t string_interner_size(const StringInterner* interner);
+
+// forget every string but keep the table's capacity; call together with
+// resetting the arena that held them
+void string_interner_clear(StringInterner* interner);
+
+// destroy the table; string bytes are released with the arena
+void string_interner_destroy(StringInterner* interner);
+
+#endif // WLANG_STRING_INTERN_H
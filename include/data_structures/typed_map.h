@@ -0,0 +1,246 @@
+#ifndef WLANG_TYPED_MAP_H
+#define WLANG_TYPED_MAP_H
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "data_structures/map_group.h"
+#include "data_structures/hash.h"
+
+// type-specialized maps: the same Swiss-table layout as Map, but keys and
+// values are stored inline with their own C types and hashing and equality
+// are called directly, so nothing is boxed into void* or called through a
+// function pointer.
+//
+//   TYPED_MAP(map_num_num, int, int, typed_hash_num, typed_equal_num,
+//             TYPED_MAP_KEEP, TYPED_MAP_DROP, TYPED_MAP_KEEP, TYPED_MAP_DROP)
+//
+// defines the struct map_num_num and static inline functions:
+//
+//   bool   map_num_num_init(map_num_num* map, size_t expected)
+//   void   map_num_num_free(map_num_num* map)
+//   bool   map_num_num_put(map_num_num* map, int key, int value)    true if new
+//   int*   map_num_num_find(const map_num_num* map, int key)        NULL if absent
+//   int    map_num_num_get(const map_num_num* map, int key, int default_value)
+//   bool   map_num_num_contains(const map_num_num* map, int key)
+//   bool   map_num_num_remove(map_num_num* map, int key)
+//   size_t map_num_num_size(const map_num_num* map)
+//   void   map_num_num_clear(map_num_num* map)
+//
+// COPY_KEY/COPY_VALUE run on stored keys and values (e.g. strdup for owned
+// strings) and FREE_KEY/FREE_VALUE when they leave the map. a map that is
+// being iterated or looked into must not be changed.
+
+// ==================== hashing ====================
+
+static inline uint64_t typed_hash_num(int key) {
+    return hash_u64((uint32_t)key);
+}
+
+static inline uint64_t typed_hash_chr(char key) {
+    return typed_hash_num((unsigned char)key);
+}
+
+// 0.0 and -0.0 compare equal, so they hash alike; NaN keys are never found
+static inline uint64_t typed_hash_real(float key) {
+    uint32_t bits = 0;
+    if (key != 0.0f) {
+        memcpy(&bits, &key, sizeof(bits));
+    }
+    return typed_hash_num((int)bits);
+}
+
+static inline uint64_t typed_hash_str(const char* key) {
+    return hash_cstring(key);
+}
+
+static inline bool typed_equal_num(int a, int b) { return a == b; }
+static inline bool typed_equal_chr(char a, char b) { return a == b; }
+static inline bool typed_equal_real(float a, float b) { return a == b; }
+static inline bool typed_equal_str(const char* a, const char* b) { return strcmp(a, b) == 0; }
+
+// ==================== ownership ====================
+
+#define TYPED_MAP_KEEP(x) (x)
+#define TYPED_MAP_DROP(x) ((void)(x))
+
+static inline const char* typed_copy_str(const char* str) {
+    return strdup(str);
+}
+
+static inline void typed_free_str(const char* str) {
+    free((void*)str);
+}
+
+// ==================== template ====================
+
+#define TYPED_MAP(NAME, KEY, VALUE, HASH, EQUAL, COPY_KEY, FREE_KEY, COPY_VALUE, FREE_VALUE) \
+                                                                                            \
+typedef struct {                                                                            \
+    KEY key;                                                                                \
+    VALUE value;                                                                            \
+} NAME##_entry;                                                                             \
+                                                                                            \
+typedef struct {                                                                            \
+    NAME##_entry* entries;                                                                  \
+    int8_t* ctrl;                                                                           \
+    size_t capacity;                                                                        \
+    size_t size;                                                                            \
+    size_t growth_left;                                                                     \
+} NAME;                                                                                     \
+                                                                                            \
+static inline bool NAME##_allocate(NAME* map, size_t capacity) {                            \
+    size_t entry_bytes = capacity * sizeof(NAME##_entry);                                   \
+    size_t ctrl_bytes = capacity + MAP_GROUP_WIDTH - 1;                                     \
+    NAME##_entry* entries = malloc(entry_bytes + ctrl_bytes);                               \
+    if (!entries) return false;                                                             \
+    map->entries = entries;                                                                 \
+    map->ctrl = (int8_t*)(entries + capacity);                                              \
+    map->capacity = capacity;                                                               \
+    map->growth_left = map_max_load(capacity);                                              \
+    memset(map->ctrl, MAP_CTRL_EMPTY, ctrl_bytes);                                          \
+    return true;                                                                            \
+}                                                                                           \
+                                                                                            \
+static inline void NAME##_set_ctrl(NAME* map, size_t index, int8_t value) {                 \
+    map->ctrl[index] = value;                                                               \
+    if (index < MAP_GROUP_WIDTH - 1) {                                                      \
+        map->ctrl[map->capacity + index] = value;                                           \
+    }                                                                                       \
+}                                                                                           \
+                                                                                            \
+static inline bool NAME##_init(NAME* map, size_t expected) {                                \
+    size_t capacity = MAP_GROUP_WIDTH;                                                      \
+    while (map_max_load(capacity) < expected) {                                             \
+        capacity *= 2;                                                                      \
+    }                                                                                       \
+    map->size = 0;                                                                          \
+    return NAME##_allocate(map, capacity);                                                  \
+}                                                                                           \
+                                                                                            \
+static inline size_t NAME##_slot(const NAME* map, KEY key, uint64_t hash) {                 \
+    size_t mask = map->capacity - 1;                                                        \
+    size_t position = map_hash_position(hash) & mask;                                       \
+    int8_t tag = map_hash_tag(hash);                                                        \
+    for (size_t stride = 0; stride <= map->capacity; ) {                                    \
+        const int8_t* group = map->ctrl + position;                                         \
+        for (MapGroupMask match = map_group_match(group, tag); match; match &= match - 1) { \
+            size_t index = (position + (size_t)__builtin_ctz(match)) & mask;                \
+            if (EQUAL(map->entries[index].key, key)) return index;                          \
+        }                                                                                   \
+        if (map_group_match_empty(group)) break;                                            \
+        stride += MAP_GROUP_WIDTH;                                                          \
+        position = (position + stride) & mask;                                              \
+    }                                                                                       \
+    return map->capacity;                                                                   \
+}                                                                                           \
+                                                                                            \
+static inline size_t NAME##_free_slot(const NAME* map, uint64_t hash) {                     \
+    size_t mask = map->capacity - 1;                                                        \
+    size_t position = map_hash_position(hash) & mask;                                       \
+    for (size_t stride = 0; ; ) {                                                           \
+        MapGroupMask free_slots = map_group_match_free(map->ctrl + position);               \
+        if (free_slots) return (position + (size_t)__builtin_ctz(free_slots)) & mask;       \
+        stride += MAP_GROUP_WIDTH;                                                          \
+        position = (position + stride) & mask;                                              \
+    }                                                                                       \
+}                                                                                           \
+                                                                                            \
+static inline bool NAME##_rehash(NAME* map, size_t capacity) {                              \
+    NAME##_entry* old_entries = map->entries;                                               \
+    int8_t* old_ctrl = map->ctrl;                                                           \
+    size_t old_capacity = map->capacity;                                                    \
+    if (!NAME##_allocate(map, capacity)) return false;                                      \
+    for (size_t i = 0; i < old_capacity; i++) {                                             \
+        if (old_ctrl[i] < 0) continue;                                                      \
+        uint64_t hash = map_mix_hash(HASH(old_entries[i].key));                             \
+        size_t index = NAME##_free_slot(map, hash);                                         \
+        NAME##_set_ctrl(map, index, map_hash_tag(hash));                                    \
+        map->entries[index] = old_entries[i];                                               \
+    }                                                                                       \
+    map->growth_left -= map->size;                                                          \
+    free(old_entries);                                                                      \
+    return true;                                                                            \
+}                                                                                           \
+                                                                                            \
+static inline VALUE* NAME##_find(const NAME* map, KEY key) {                                \
+    size_t index = NAME##_slot(map, key, map_mix_hash(HASH(key)));                          \
+    return index < map->capacity ? &map->entries[index].value : NULL;                       \
+}                                                                                           \
+                                                                                            \
+static inline VALUE NAME##_get(const NAME* map, KEY key, VALUE default_value) {             \
+    VALUE* value = NAME##_find(map, key);                                                   \
+    return value ? *value : default_value;                                                  \
+}                                                                                           \
+                                                                                            \
+static inline bool NAME##_contains(const NAME* map, KEY key) {                              \
+    return NAME##_find(map, key) != NULL;                                                   \
+}                                                                                           \
+                                                                                            \
+static inline bool NAME##_put(NAME* map, KEY key, VALUE value) {                            \
+    uint64_t hash = map_mix_hash(HASH(key));                                                \
+    size_t index = NAME##_slot(map, key, hash);                                             \
+    if (index < map->capacity) {                                                            \
+        NAME##_entry* entry = &map->entries[index];                                         \
+        VALUE copied = COPY_VALUE(value);                                                   \
+        FREE_VALUE(entry->value);                                                           \
+        entry->value = copied;                                                              \
+        return false;                                                                       \
+    }                                                                                       \
+    index = NAME##_free_slot(map, hash);                                                    \
+    if (map->ctrl[index] == MAP_CTRL_EMPTY && map->growth_left == 0) {                      \
+        size_t capacity = map->size * 32 <= map->capacity * 25                              \
+            ? map->capacity : map->capacity * 2;                                            \
+        if (!NAME##_rehash(map, capacity)) return false;                                    \
+        index = NAME##_free_slot(map, hash);                                                \
+    }                                                                                       \
+    if (map->ctrl[index] == MAP_CTRL_EMPTY) {                                               \
+        map->growth_left--;                                                                 \
+    }                                                                                       \
+    NAME##_set_ctrl(map, index, map_hash_tag(hash));                                        \
+    map->entries[index].key = COPY_KEY(key);                                                \
+    map->entries[index].value = COPY_VALUE(value);                                          \
+    map->size++;                                                                            \
+    return true;                                                                            \
+}                                                                                           \
+                                                                                            \
+static inline bool NAME##_remove(NAME* map, KEY key) {                                      \
+    size_t index = NAME##_slot(map, key, map_mix_hash(HASH(key)));                          \
+    if (index == map->capacity) return false;                                               \
+    FREE_KEY(map->entries[index].key);                                                      \
+    FREE_VALUE(map->entries[index].value);                                                  \
+    map->size--;                                                                            \
+    if (map_slot_never_full(map->ctrl, index, map->capacity - 1)) {                         \
+        NAME##_set_ctrl(map, index, MAP_CTRL_EMPTY);                                        \
+        map->growth_left++;                                                                 \
+    } else {                                                                                \
+        NAME##_set_ctrl(map, index, MAP_CTRL_DELETED);                                      \
+    }                                                                                       \
+    return true;                                                                            \
+}                                                                                           \
+                                                                                            \
+static inline size_t NAME##_size(const NAME* map) {                                         \
+    return map->size;                                                                       \
+}                                                                                           \
+                                                                                            \
+static inline void NAME##_clear(NAME* map) {                                                \
+    for (size_t i = 0; i < map->capacity; i++) {                                            \
+        if (map->ctrl[i] < 0) continue;                                                     \
+        FREE_KEY(map->entries[i].key);                                                      \
+        FREE_VALUE(map->entries[i].value);                                                  \
+    }                                                                                       \
+    memset(map->ctrl, MAP_CTRL_EMPTY, map->capacity + MAP_GROUP_WIDTH - 1);                 \
+    map->size = 0;                                                                          \
+    map->growth_left = map_max_load(map->capacity);                                         \
+}                                                                                           \
+                                                                                            \
+static inline void NAME##_free(NAME* map) {                                                 \
+    NAME##_clear(map);                                                                      \
+    free(map->entries);                                                                     \
+    map->entries = NULL;                                                                    \
+    map->ctrl = NULL;                                                                       \
+    map->capacity = 0;                                                                      \
+}
+
+#endif
@@ -6,9 +6,13 @@
 
 #include "ast.h"
 #include "types.h"
+#include "codegen/emitter.h"
 
-void generate(FILE* output, ASTNode* node, int indent_level);
-void generate_code(FILE* output, ASTNode* node);
-void generate_log_statement(FILE* output, LogElement* elements, int indent_level);
+// the w() function among a program's functions, or NULL
+ASTNode* find_entry_point(ASTNode* functions);
+
+void generate(Emitter* output, ASTNode* node, int indent_level);
+void generate_code(Emitter* output, ASTNode* node);
+void generate_log_statement(Emitter* output, LogElement* elements, int indent_level);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,65 @@
+#ifndef W_INSTRUMENT_H
+#define W_INSTRUMENT_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// self-instrumentation behind --time-report and --mem-report. both are off
+// by default, and then every hook costs one branch on a flag. totals are
+// summed over every file of a run, including batch workers.
+
+typedef enum {
+    PHASE_LEX,
+    PHASE_PARSE,            // parse() minus the time spent in the lexer
+    PHASE_SEMANTIC,
+    PHASE_GENERATE,
+    PHASE_COUNT
+} Phase;
+
+typedef enum {
+    MEM_AST,                // nodes and interned names in the AST arena
+    MEM_SYMBOLS,            // scopes, symbols, function table
+    MEM_REGISTRY,           // type and token registries
+    MEM_MAP,                // generic Map tables, entries and key copies
+    MEM_PARSER,             // parser state and argument lists
+    MEM_EMITTER,            // output buffers
+    MEM_SUBSYSTEM_COUNT
+} MemSubsystem;
+
+typedef enum {
+    REPORT_TABLE,
+    REPORT_JSON
+} ReportFormat;
+
+// set before any compilation starts and never changed afterwards
+extern bool instrument_timing;
+extern bool instrument_memory;
+
+// ==================== recording ====================
+
+// count one allocation (malloc, calloc or realloc) of bytes
+void instrument_count_alloc(MemSubsystem subsystem, size_t bytes);
+
+#define INSTRUMENT_ALLOC(subsystem, bytes) \
+    do { if (instrument_memory) instrument_count_alloc((subsystem), (bytes)); } while (0)
+
+// the map library's allocation hook (map_alloc_hook), counted under MEM_MAP
+void instrument_count_map_alloc(size_t bytes);
+
+// monotonic wall clock and calling thread's CPU clock, in seconds
+double instrument_wall_time(void);
+double instrument_cpu_time(void);
+
+// add one file's time for a phase
+void instrument_add_phase(Phase phase, double wall, double cpu);
+
+// count a finished compilation
+void instrument_count_file(void);
+
+// ==================== reporting ====================
+
+// print whichever reports are enabled
+void instrument_print_report(FILE* out, ReportFormat format);
+
+#endif
@@ -0,0 +1,27 @@
+#ifndef W_OPTIMIZE_H
+#define W_OPTIMIZE_H
+
+#include "ast.h"
+
+// AST optimization pass: runs after annotate_program() and before
+// generate_code(), only on programs without errors.
+//
+// folds constant num, real, chr and bool subexpressions with the promotion
+// rules of get_operation_type(), applies x*1, x/1, x+0, x-0 and (for
+// side-effect free num operands) x*0, and joins constant string
+// concatenations into one literal. folded nodes keep their expr_type.
+void fold_program(ASTNode* program);
+
+// drop every function that w() cannot reach through calls (directly or via
+// global initializers), so neither its prototype nor its body is generated.
+// with report_removed set, each dropped function is noted on diagnostics.
+// does nothing without an entry point or after errors.
+void eliminate_dead_functions(ASTNode* program);
+
+// whole-program mode: order function definitions callee-first so only
+// recursive calls need prototypes, make every function but w() static and
+// small leaf functions static inline. with hot_cold set on the context,
+// also mark functions hot or cold by how often one run of w() calls them.
+void plan_whole_program(ASTNode* program);
+
+#endif
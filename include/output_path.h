@@ -0,0 +1,15 @@
+#ifndef W_OUTPUT_PATH_H
+#define W_OUTPUT_PATH_H
+
+#include <stdbool.h>
+
+// where batch mode puts the C for an input: output_dir/<basename without .w>.c
+// returns: malloc'd path or NULL on allocation failure
+char* output_path_for(const char* output_dir, const char* input);
+
+// batch outputs are named after the input's basename alone, so dir/a/x.w and
+// dir/b/x.w would write the same file; reports every such pair to stderr
+// returns: false on a collision or allocation failure
+bool output_paths_distinct(const char* output_dir, const char** inputs, int count);
+
+#endif
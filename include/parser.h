@@ -29,8 +29,6 @@ ASTNode* parse_function(void);
 const char* token_to_string(TokenType token);
 const char* type_to_string(DataType type);
 
-extern ParserState parser_state;
-
 ParserState getParserState(void);
 
 #endif
\ No newline at end of file
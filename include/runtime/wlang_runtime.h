@@ -2,12 +2,21 @@
 #define WLANG_RUNTIME_H
 
 #include "data_structures/map.h"
+#include "data_structures/concurrent_map.h"
 #include <stdbool.h>
 
 // ==================== runtime map helpers ====================
 // these functions are used in the transpiled C code when W Lang users
 // write map(T, U) in their W Lang programs.
 
+// ==================== startup ====================
+
+// seed map hashing for this run; call once before the first map. generated
+// code does not call it yet: it uses no maps until the map syntax is lowered
+// (grammar/status.txt, item 10), so a program that links the runtime today
+// calls it itself or hashes with the fixed default seed
+void wlang_runtime_init(void);
+
 // ==================== map creation ====================
 
 // create map with integer keys and integer values: map(num, num)
@@ -51,6 +60,21 @@ float wlang_map_get_real_real(Map* map, float key, float default_value);
 float wlang_map_get_num_real(Map* map, int key, float default_value);
 int wlang_map_get_chr_num(Map* map, char key, int default_value);
 
+// add delta to the value of key, an absent key counting as 0: m[k] = m[k] + delta
+// returns: the new value (0 if the key could not be inserted)
+int wlang_map_add_num_num(Map* map, int key, int delta);
+int wlang_map_add_str_num(Map* map, const char* key, int delta);
+int wlang_map_add_chr_num(Map* map, char key, int delta);
+
+// batch operations: the same results as one call per key, with the cache
+// misses of neighbouring keys overlapped (see map_find_many)
+void wlang_map_get_many_num_num(Map* map, const int* keys, int count, int* values_out,
+                                int default_value);
+void wlang_map_get_many_str_num(Map* map, const char* const* keys, int count, int* values_out,
+                                int default_value);
+// returns: number of new entries
+int wlang_map_put_many_num_num(Map* map, const int* keys, const int* values, int count);
+
 // contains operations for common key types
 bool wlang_map_contains_num(Map* map, int key);
 bool wlang_map_contains_str(Map* map, const char* key);
@@ -72,10 +96,41 @@ size_t wlang_map_size(Map* map);
 // check if map is empty
 bool wlang_map_is_empty(Map* map);
 
+// presize for count entries, so filling the map never resizes it
+bool wlang_map_reserve(Map* map, int count);
+
 // clear all entries
 void wlang_map_clear(Map* map);
 
 // destroy the map
 void wlang_map_destroy(Map* map);
 
+// ==================== concurrent maps ====================
+// maps shared between threads of a W program (see concurrent_map.h); every
+// call is atomic. values are integers, so nothing returned can be freed by
+// another thread.
+
+ConcurrentMap* wlang_cmap_create_num_num(void);
+ConcurrentMap* wlang_cmap_create_str_num(void);
+
+bool wlang_cmap_put_num_num(ConcurrentMap* cmap, int key, int value);
+bool wlang_cmap_put_str_num(ConcurrentMap* cmap, const char* key, int value);
+
+int wlang_cmap_get_num_num(ConcurrentMap* cmap, int key, int default_value);
+int wlang_cmap_get_str_num(ConcurrentMap* cmap, const char* key, int default_value);
+
+// atomic m[k] = m[k] + delta, an absent key counting as 0
+// returns: the new value (0 if the key could not be inserted)
+int wlang_cmap_add_num_num(ConcurrentMap* cmap, int key, int delta);
+int wlang_cmap_add_str_num(ConcurrentMap* cmap, const char* key, int delta);
+
+bool wlang_cmap_contains_num(ConcurrentMap* cmap, int key);
+bool wlang_cmap_contains_str(ConcurrentMap* cmap, const char* key);
+
+bool wlang_cmap_remove_num(ConcurrentMap* cmap, int key);
+bool wlang_cmap_remove_str(ConcurrentMap* cmap, const char* key);
+
+size_t wlang_cmap_size(ConcurrentMap* cmap);
+void wlang_cmap_destroy(ConcurrentMap* cmap);
+
 #endif // WLANG_RUNTIME_H
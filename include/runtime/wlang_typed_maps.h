@@ -0,0 +1,39 @@
+#ifndef WLANG_TYPED_MAPS_H
+#define WLANG_TYPED_MAPS_H
+
+#include "data_structures/typed_map.h"
+
+// ==================== typed runtime maps ====================
+// one instantiation per map(K, V) the runtime supports, named map_K_V after
+// the W Lang types. unlike the Map-based wlang_map_* helpers, keys and values
+// are stored unboxed (no malloc per real, no intptr_t casts) and hashing is
+// a direct call. str keys and values are copied in and freed on removal.
+//
+//   map_num_str names;
+//   map_num_str_init(&names, 0);
+//   map_num_str_put(&names, 1, "one");
+//   const char* name = map_num_str_get(&names, 1, "");
+//   map_num_str_free(&names);
+
+TYPED_MAP(map_num_num, int, int, typed_hash_num, typed_equal_num,
+          TYPED_MAP_KEEP, TYPED_MAP_DROP, TYPED_MAP_KEEP, TYPED_MAP_DROP)
+
+TYPED_MAP(map_num_str, int, const char*, typed_hash_num, typed_equal_num,
+          TYPED_MAP_KEEP, TYPED_MAP_DROP, typed_copy_str, typed_free_str)
+
+TYPED_MAP(map_str_num, const char*, int, typed_hash_str, typed_equal_str,
+          typed_copy_str, typed_free_str, TYPED_MAP_KEEP, TYPED_MAP_DROP)
+
+TYPED_MAP(map_str_str, const char*, const char*, typed_hash_str, typed_equal_str,
+          typed_copy_str, typed_free_str, typed_copy_str, typed_free_str)
+
+TYPED_MAP(map_real_real, float, float, typed_hash_real, typed_equal_real,
+          TYPED_MAP_KEEP, TYPED_MAP_DROP, TYPED_MAP_KEEP, TYPED_MAP_DROP)
+
+TYPED_MAP(map_num_real, int, float, typed_hash_num, typed_equal_num,
+          TYPED_MAP_KEEP, TYPED_MAP_DROP, TYPED_MAP_KEEP, TYPED_MAP_DROP)
+
+TYPED_MAP(map_chr_num, char, int, typed_hash_chr, typed_equal_chr,
+          TYPED_MAP_KEEP, TYPED_MAP_DROP, TYPED_MAP_KEEP, TYPED_MAP_DROP)
+
+#endif
@@ -0,0 +1,16 @@
+#ifndef W_SEMANTIC_H
+#define W_SEMANTIC_H
+
+#include "types.h"
+#include "ast.h"
+
+// type annotation pass: runs once between parse() and generate_code().
+// computes every expression's type bottom-up, caches it in Expression.expr_type
+// and reports initialization, assignment, call and return type errors.
+// returns: false if it reported any error; the program must not be generated
+bool annotate_program(ASTNode* program);
+
+// cached type of an expression node (TYPE_ZIL for non-expressions)
+DataType expression_type(ASTNode* node);
+
+#endif
@@ -0,0 +1,34 @@
+#ifndef W_SOURCE_H
+#define W_SOURCE_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "types.h"
+
+// input source for the lexer. regular files are memory-mapped and scanned in
+// place, so tokens are slices of the mapping; anything that cannot be mapped
+// (pipes, terminals) falls back to flex reading from a FILE*.
+typedef struct {
+    char* data;             // mapped contents followed by two NUL bytes
+    size_t length;          // bytes of source text
+    size_t mapped_size;     // size of the mapping, 0 when streaming or borrowed
+    FILE* stream;           // fallback input, NULL when mapped
+} SourceFile;
+
+// open a source file, mapping it when possible
+// returns: false if the file cannot be opened
+bool source_open(SourceFile* source, const char* path);
+
+// scan a caller-owned buffer in place; data[length] and data[length + 1]
+// must be NUL and the buffer must outlive the compilation
+void source_from_memory(SourceFile* source, char* data, size_t length);
+
+// point a scanner at the source (scan buffer or input stream)
+bool source_attach_lexer(SourceFile* source, yyscan_t scanner);
+
+// unmap or close the source (borrowed buffers are left alone)
+void source_close(SourceFile* source);
+
+#endif
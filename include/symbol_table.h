@@ -6,32 +6,44 @@
 #include "types.h"
 #include "ast.h"
 
+#include "data_structures/map.h"
+
 typedef struct Symbol {
-    char* name;
+    const char* name;
     DataType type;
-    struct Symbol* next;
 } Symbol;
 
+// one lexical block: its own hash table of symbols plus a link outward
+typedef struct Scope {
+    Map* symbols;               // interned name -> Symbol*
+    struct Scope* parent;
+    int depth;                  // 0 for the file scope
+} Scope;
+
+// stack of scopes; the innermost scope is searched first
 typedef struct SymbolTable {
-    Symbol* head;
+    Scope* current;
 } SymbolTable;
 
 typedef struct FunctionSymbol {
-    char* name;
+    const char* name;
     DataType return_type;
-    struct FunctionSymbol* next;
 } FunctionSymbol;
 
 typedef struct FunctionTable {
-    FunctionSymbol* head;
+    Map* functions;             // interned name -> FunctionSymbol*
 } FunctionTable;
 
+// tables compare names by address: every name passed in must come from
+// ast_intern / ast_intern_len
+
 SymbolTable* getSymbolTable(void);
 void create_symbol_table(void);
 void free_symbol_table(void);
+void push_scope(SymbolTable* table);
+void pop_scope(SymbolTable* table);
 bool add_symbol(SymbolTable* table, const char* name, DataType type);
 Symbol* lookup_symbol(SymbolTable* table, const char* name);
-DataType get_expression_type(ASTNode* node, SymbolTable* table);
 
 FunctionTable* getFunctionTable(void);
 void create_function_table(void);
@@ -43,6 +55,4 @@ bool compare_types(DataType left, DataType right);
 DataType get_operation_type(DataType left, DataType right, OperatorType op);
 bool can_convert_type(DataType from, DataType to);
 
-extern SymbolTable* symbol_table;
-
 #endif
\ No newline at end of file
@@ -0,0 +1,47 @@
+#ifndef FUNCTION_CACHE_H
+#define FUNCTION_CACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "ast.h"
+
+// on-disk cache of generated C, one file per function definition. the key is a
+// hash of the function's AST together with the signatures of the functions it
+// calls, so a function is regenerated only when something it depends on changed.
+// entries are written with an atomic rename, so several processes or threads
+// may share one cache directory.
+
+typedef struct {
+    char* dir;
+    size_t hits;
+    size_t misses;
+} FunctionCache;
+
+// ==================== lifecycle ====================
+
+// use (and create if missing) a cache directory
+// returns: cache or NULL if the directory cannot be created
+FunctionCache* function_cache_open(const char* dir);
+
+// free the handle; cached files stay on disk
+void function_cache_close(FunctionCache* cache);
+
+// ==================== keys ====================
+
+// content hash of a NODE_FUNCTION subtree and its callees' signatures;
+// needs the function table of the parse that produced the node
+uint64_t function_cache_key(ASTNode* function);
+
+// ==================== lookup & store ====================
+
+// key every function of the program and attach cached code to the ones that
+// are unchanged; those skip annotation and generation
+void function_cache_lookup_program(FunctionCache* cache, ASTNode* program);
+
+// record the generated C for a key
+// returns: false if the entry could not be written (the build still succeeds)
+bool function_cache_store(FunctionCache* cache, uint64_t key, const char* code, size_t length);
+
+#endif // FUNCTION_CACHE_H
@@ -23,10 +23,9 @@ typedef struct {
 
 // ==================== initialization & cleanup ====================
 
-// initialize token registry (call at transpiler startup)
+// the registry is a constant table indexed by token; init and cleanup do
+// nothing and remain for existing callers
 void token_registry_init(void);
-
-// cleanup token registry (call at transpiler shutdown)
 void token_registry_cleanup(void);
 
 // ==================== lookup functions ====================
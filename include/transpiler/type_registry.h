@@ -2,7 +2,6 @@
 #define TYPE_REGISTRY_H
 
 #include "types.h"
-#include "data_structures/map.h"
 
 // type mapping structure - contains all information about a W Lang type
 typedef struct {
@@ -16,10 +15,9 @@ typedef struct {
 
 // ==================== initialization & cleanup ====================
 
-// initialize the type registry (must be called at transpiler startup)
+// the registry is a set of constant tables; init and cleanup do nothing and
+// remain for existing callers
 void type_registry_init(void);
-
-// cleanup the type registry (call at transpiler shutdown)
 void type_registry_cleanup(void);
 
 // ==================== lookup functions ====================
@@ -30,10 +28,10 @@ const TypeMapping* type_registry_get_by_enum(DataType type);
 // lookup by TokenType value (e.g., NUM)
 const TypeMapping* type_registry_get_by_token(TokenType token);
 
-// lookup by W Lang type name (e.g., "num")
+// lookup by W Lang type name (e.g., "num"), through a perfect hash
 const TypeMapping* type_registry_get_by_wlang_name(const char* name);
 
-// lookup by C type name (e.g., "int")
+// lookup by C type name (e.g., "int"), through a perfect hash
 const TypeMapping* type_registry_get_by_c_name(const char* name);
 
 // ==================== convenience functions ====================
@@ -76,9 +76,17 @@ typedef enum {
     IS
 } TokenType;
 
+// text of an identifier, keyword or string literal token. when the source is
+// mapped this points straight into the mapping; when streaming it points into
+// yytext and is only valid until the next yylex() call.
+typedef struct {
+    const char* start;
+    size_t length;
+} TokenSlice;
+
 typedef struct {
     union {
-        char* string;
+        TokenSlice slice;
         int number;
         double float_val;
         char char_val;
@@ -86,9 +94,11 @@ typedef struct {
     };
 } YYSTYPE;
 
-extern YYSTYPE yylval;
-extern int yylineno;
-extern TokenType token;
+// opaque flex scanner handle; every scanner carries its own input and line count
+#ifndef YY_TYPEDEF_YY_SCANNER_T
+#define YY_TYPEDEF_YY_SCANNER_T
+typedef void* yyscan_t;
+#endif
 
 typedef enum {
     TYPE_NUM,
@@ -138,19 +148,20 @@ typedef enum {
 typedef struct LogElement {
     NodeType type;
     union {
-        char* string;
+        const char* string;
         int number;
         double float_val;
         char char_val;
         bool bool_val;
-        char* variable;
+        const char* variable;
     } value;
+    DataType var_type;          // resolved type of a NODE_VARIABLE element
     struct LogElement* next;
 } LogElement;
 
 typedef struct {
-    char* current_name;
-    char* current_return_type;
+    const char* current_name;
+    const char* current_return_type;
     int has_return;
     int return_value_required;
 } FunctionContext;
@@ -161,11 +172,16 @@ typedef struct {
     int block_capacity;
     int error_count;
     int in_function_body;
+    int report_line;            // line for errors raised after lexing (0 = use yylineno)
     FunctionContext* function_context;
 } ParserState;
 
-extern int yylex();
-extern char* yytext;
-extern FILE* yyin;
+extern int yylex(YYSTYPE* yylval_param, yyscan_t yyscanner);
+extern int yylex_init(yyscan_t* scanner);
+extern int yylex_destroy(yyscan_t yyscanner);
+extern int yyget_lineno(yyscan_t yyscanner);
+extern void yyset_in(FILE* in_str, yyscan_t yyscanner);
+extern bool lexer_scan_buffer(char* data, size_t size, yyscan_t scanner);
+extern void lexer_reset(yyscan_t scanner);
 
 #endif
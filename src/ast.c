@@ -3,10 +3,59 @@
 #include <string.h>
 
 #include "ast.h"
+#include "context.h"
 #include "parser.h"
 #include "symbol_table.h"
+#include "data_structures/arena.h"
+#include "data_structures/string_intern.h"
+#include "instrument.h"
+
+// ==================== compilation arena ====================
+// the arena and interner belong to the current context, so every
+// compilation has its own storage for nodes and identifiers
+
+bool init_ast(void) {
+    TranspilerContext* ctx = current_context();
+    if (ctx->arena != NULL) {
+        return true;
+    }
+
+    ctx->arena = arena_create(0);
+    ctx->strings = string_interner_create(ctx->arena);
+    if (!ctx->arena || !ctx->strings) {
+        fprintf(stderr, "Failed to initialize AST arena\n");
+        return false;
+    }
+    return true;
+}
+
+void* ast_alloc(size_t size) {
+    INSTRUMENT_ALLOC(MEM_AST, size);
+    return arena_alloc(current_context()->arena, size);
+}
 
-ASTNode* ast = NULL;
+// only a string seen for the first time takes arena space
+static const char* count_interned(StringInterner* strings, size_t before,
+                                  const char* interned, size_t len) {
+    if (instrument_memory && string_interner_size(strings) > before) {
+        instrument_count_alloc(MEM_AST, len + 1);
+    }
+    return interned;
+}
+
+const char* ast_intern(const char* str) {
+    StringInterner* strings = current_context()->strings;
+    size_t before = string_interner_size(strings);
+    return count_interned(strings, before, string_intern(strings, str), strlen(str));
+}
+
+const char* ast_intern_len(const char* str, size_t len) {
+    StringInterner* strings = current_context()->strings;
+    size_t before = string_interner_size(strings);
+    return count_interned(strings, before, string_intern_len(strings, str, len), len);
+}
+
+// ==================== node construction ====================
 
 void set_node_location(ASTNode* node, SourceLocation loc) {
     if (node) {
@@ -21,7 +70,7 @@ static void init_expression(Expression* expr, NodeType type, SourceLocation loc)
 }
 
 ASTNode* create_program_node(SourceLocation loc) {
-    ASTNode* node = malloc(sizeof(ASTNode));
+    ASTNode* node = ast_alloc(sizeof(ASTNode));
     if (!node) {
         parser_error("Memory allocation failed");
         return NULL;
@@ -34,8 +83,8 @@ ASTNode* create_program_node(SourceLocation loc) {
     return node;
 }
 
-ASTNode* create_function_node(char* return_type, char* name, Parameter* parameters, int param_count, ASTNode* body, int has_return, SourceLocation loc) {
-    ASTNode* node = malloc(sizeof(ASTNode));
+ASTNode* create_function_node(const char* return_type, const char* name, Parameter* parameters, int param_count, ASTNode* body, int has_return, SourceLocation loc) {
+    ASTNode* node = ast_alloc(sizeof(ASTNode));
     if (!node) {
         parser_error("Memory allocation failed");
         return NULL;
@@ -48,23 +97,27 @@ ASTNode* create_function_node(char* return_type, char* name, Parameter* paramete
     node->data.function.param_count = param_count;
     node->data.function.body = body;
     node->data.function.has_return = has_return;
+    node->data.function.cache_key = 0;
+    node->data.function.cached_code = NULL;
+    node->data.function.cached_length = 0;
+    node->data.function.linkage = LINKAGE_EXTERN;
+    node->data.function.hotness = HOTNESS_NORMAL;
+    node->data.function.needs_prototype = true;
     node->next = NULL;
     return node;
 }
 
-ASTNode* create_function_call_node(char* name, ASTNode** args, int arg_count, SourceLocation loc) {
-    ASTNode* node = malloc(sizeof(ASTNode));
+ASTNode* create_function_call_node(const char* name, ASTNode** args, int arg_count, SourceLocation loc) {
+    ASTNode* node = ast_alloc(sizeof(ASTNode));
     if (!node) {
         parser_error("Memory allocation failed");
         return NULL;
     }
     node->type = NODE_FUNCTION_CALL;
     init_expression(&node->data.function_call.base, NODE_FUNCTION_CALL, loc);
-    node->data.function_call.name = strdup(name);
-    node->data.function_call.args = malloc(sizeof(ASTNode*) * arg_count);
+    node->data.function_call.name = name;
+    node->data.function_call.args = ast_alloc(sizeof(ASTNode*) * arg_count);
     if (!node->data.function_call.args) {
-        free(node->data.function_call.name);
-        free(node);
         parser_error("Memory allocation failed for function arguments");
         return NULL;
     }
@@ -75,17 +128,31 @@ ASTNode* create_function_call_node(char* name, ASTNode** args, int arg_count, So
 }
 
 ASTNode* create_log_node(LogElement* elements) {
-    ASTNode* node = malloc(sizeof(ASTNode));
+    ASTNode* node = ast_alloc(sizeof(ASTNode));
     if (!node) {
         parser_error("Memory allocation failed");
         return NULL;
     }
     node->type = NODE_LOG;
     node->data.log.elements = elements;
+    node->next = NULL;
+    return node;
+}
+
+ASTNode* create_return_node(ASTNode* expression, SourceLocation loc) {
+    ASTNode* node = ast_alloc(sizeof(ASTNode));
+    if (!node) {
+        parser_error("Memory allocation failed");
+        return NULL;
+    }
+    node->type = NODE_RETURN;
+    set_node_location(node, loc);
+    node->data.return_statement.expression = expression;
+    node->next = NULL;
     return node;
 }
 
-ASTNode* create_assignment_node(char* target, ASTNode* value, SourceLocation loc) {
+ASTNode* create_assignment_node(const char* target, ASTNode* value, SourceLocation loc) {
     // first, validate our inputs
     if (!target || !value) {
         parser_error("Invalid assignment: missing target or value");
@@ -93,7 +160,7 @@ ASTNode* create_assignment_node(char* target, ASTNode* value, SourceLocation loc
     }
 
     // create and initialize the node
-    ASTNode* node = malloc(sizeof(ASTNode));
+    ASTNode* node = ast_alloc(sizeof(ASTNode));
     if (!node) {
         parser_error("Memory allocation failed for assignment node");
         return NULL;
@@ -107,19 +174,11 @@ ASTNode* create_assignment_node(char* target, ASTNode* value, SourceLocation loc
     init_expression(&node->data.assignment.base, NODE_ASSIGNMENT, loc);
 
     // set up the assignment-specific data
-    node->data.assignment.target = strdup(target);  // Make a copy of the target name
-    if (!node->data.assignment.target) {
-        parser_error("Memory allocation failed for assignment target");
-        free(node);
-        return NULL;
-    }
+    node->data.assignment.target = target;
     
     node->data.assignment.value = value;
     node->next = NULL;
 
-    // the type of an assignment expression is the type of its value
-    node->data.assignment.base.expr_type = get_expression_type(value, getSymbolTable());
-
     // verify that the target exists in the symbol table
     Symbol* symbol = lookup_symbol(getSymbolTable(), target);
     if (!symbol) {
@@ -127,31 +186,18 @@ ASTNode* create_assignment_node(char* target, ASTNode* value, SourceLocation loc
         snprintf(error_msg, sizeof(error_msg), 
                 "Assignment to undeclared variable '%s'", target);
         parser_error(error_msg);
-        free(node->data.assignment.target);
-        free(node);
         return NULL;
     }
 
-    // check type compatibility
-    if (!compare_types(symbol->type, node->data.assignment.base.expr_type)) {
-        char error_msg[100];
-        snprintf(error_msg, sizeof(error_msg),
-                "Type mismatch in assignment to '%s': cannot assign %s to %s",
-                target,
-                type_to_string(node->data.assignment.base.expr_type),
-                type_to_string(symbol->type));
-        parser_error(error_msg);
-        free(node->data.assignment.target);
-        free(node);
-        return NULL;
-    }
+    // type compatibility is checked by the annotation pass
+    node->data.assignment.target_type = symbol->type;
 
     return node;
 }
 
 
 ASTNode* create_binary_expr_node(ASTNode* left, ASTNode* right, char operator, SourceLocation loc) {
-    ASTNode* node = malloc(sizeof(ASTNode));
+    ASTNode* node = ast_alloc(sizeof(ASTNode));
     if (!node) {
         parser_error("Memory allocation failed");
         return NULL;
@@ -166,7 +212,7 @@ ASTNode* create_binary_expr_node(ASTNode* left, ASTNode* right, char operator, S
 }
 
 ASTNode* create_unary_expr_node(char operator, ASTNode* operand, SourceLocation loc) {
-    ASTNode* node = malloc(sizeof(ASTNode));
+    ASTNode* node = ast_alloc(sizeof(ASTNode));
     if (!node) {
         parser_error("Memory allocation failed");
         return NULL;
@@ -180,7 +226,7 @@ ASTNode* create_unary_expr_node(char operator, ASTNode* operand, SourceLocation
 }
 
 ASTNode* create_number_node(int value, SourceLocation loc) {
-    ASTNode* node = malloc(sizeof(ASTNode));
+    ASTNode* node = ast_alloc(sizeof(ASTNode));
     if (!node) {
         parser_error("Memory allocation failed");
         return NULL;
@@ -193,8 +239,8 @@ ASTNode* create_number_node(int value, SourceLocation loc) {
     return node;
 }
 
-ASTNode* create_string_node(char* value, SourceLocation loc) {
-    ASTNode* node = malloc(sizeof(ASTNode));
+ASTNode* create_string_node(const char* value, SourceLocation loc) {
+    ASTNode* node = ast_alloc(sizeof(ASTNode));
     if (!node) {
         parser_error("Memory allocation failed");
         return NULL;
@@ -202,13 +248,13 @@ ASTNode* create_string_node(char* value, SourceLocation loc) {
     node->type = NODE_STRING;
     init_expression(&node->data.string.base, NODE_STRING, loc);
     node->data.string.base.expr_type = TYPE_STR;
-    node->data.string.value = strdup(value);
+    node->data.string.value = value;
     node->next = NULL;
     return node;
 }
 
 ASTNode* create_float_node(double value, SourceLocation loc) {
-    ASTNode* node = malloc(sizeof(ASTNode));
+    ASTNode* node = ast_alloc(sizeof(ASTNode));
     if (!node) {
         parser_error("Memory allocation failed for float node");
         return NULL;
@@ -229,7 +275,7 @@ ASTNode* create_float_node(double value, SourceLocation loc) {
 }
 
 ASTNode* create_char_node(char value, SourceLocation loc) {
-    ASTNode* node = malloc(sizeof(ASTNode));
+    ASTNode* node = ast_alloc(sizeof(ASTNode));
     if (!node) {
         parser_error("Memory allocation failed for char node");
         return NULL;
@@ -250,7 +296,7 @@ ASTNode* create_char_node(char value, SourceLocation loc) {
 }
 
 ASTNode* create_bool_node(bool value, SourceLocation loc) {
-    ASTNode* node = malloc(sizeof(ASTNode));
+    ASTNode* node = ast_alloc(sizeof(ASTNode));
     if (!node) {
         parser_error("Memory allocation failed for bool node");
         return NULL;
@@ -270,109 +316,80 @@ ASTNode* create_bool_node(bool value, SourceLocation loc) {
     return node;
 }
 
-ASTNode* create_variable_node(char* name, SourceLocation loc) {
-    ASTNode* node = malloc(sizeof(ASTNode));
+ASTNode* create_variable_node(const char* name, SourceLocation loc) {
+    ASTNode* node = ast_alloc(sizeof(ASTNode));
     if (!node) {
         parser_error("Memory allocation failed");
         return NULL;
     }
     node->type = NODE_VARIABLE;
     init_expression(&node->data.variable.base, NODE_VARIABLE, loc);
-    node->data.variable.name = strdup(name);
+    node->data.variable.name = name;
     node->next = NULL;
+
+    // resolve now, while the declaring scope is still on the stack
+    Symbol* symbol = lookup_symbol(getSymbolTable(), node->data.variable.name);
+    if (!symbol) {
+        char error_msg[100];
+        snprintf(error_msg, sizeof(error_msg),
+                "Undefined variable: '%s'", node->data.variable.name);
+        parser_error(error_msg);
+        return node;
+    }
+    node->data.variable.base.expr_type = symbol->type;
+
     return node;
 }
 
-ASTNode* create_var_declaration_node(char* name, DataType type, ASTNode* init_expr, SourceLocation loc) {
-    ASTNode* node = malloc(sizeof(ASTNode));
+ASTNode* create_var_declaration_node(const char* name, DataType type, ASTNode* init_expr, SourceLocation loc) {
+    ASTNode* node = ast_alloc(sizeof(ASTNode));
     if (!node) {
         parser_error("Memory allocation failed");
         return NULL;
     }
     node->type = NODE_VAR_DECLARATION;
     set_node_location(node, loc);
-    node->data.var_declaration.name = strdup(name);
+    node->data.var_declaration.name = name;
     node->data.var_declaration.type = type;
     node->data.var_declaration.init_expr = init_expr;
     node->next = NULL;
     return node;
 }
 
-void free_log_elements(LogElement* elements) {
-    LogElement* current = elements;
-    while (current != NULL) {
-        LogElement* next = current->next;
-        if (current->type == NODE_STRING) {
-            free(current->value.string);
-        }
-        free(current);
-        current = next;
+Parameter* create_parameter(const char* name, DataType type) {
+    Parameter* param = ast_alloc(sizeof(Parameter));
+    if (!param) {
+        parser_error("Memory allocation failed for parameter");
+        return NULL;
     }
+    param->name = name;
+    param->type = type;
+    param->next = NULL;
+    return param;
 }
 
-void free_ast(ASTNode* node) {
-    if (node) {
-        switch (node->type) {
-            case NODE_PROGRAM:
-                free_ast(node->data.program.functions);
-                free_ast(node->data.program.globals);
-                break;
-            case NODE_FUNCTION: {
-                free(node->data.function.return_type);
-                free(node->data.function.name);
-                // free parameters
-                Parameter* param = node->data.function.parameters;
-                while (param != NULL) {
-                    Parameter* next = param->next;
-                    free(param->name);
-                    free(param);
-                    param = next;
-                }
-                free_ast(node->data.function.body);
-                break;
-            }
-            case NODE_FUNCTION_CALL:
-                free(node->data.function_call.name);
-                if (node->data.function_call.args) {
-                    for (int i = 0; i < node->data.function_call.arg_count; i++) {
-                        free_ast(node->data.function_call.args[i]);
-                    }
-                    free(node->data.function_call.args);
-                }
-                break;
-            case NODE_LOG:
-                free_log_elements(node->data.log.elements);
-                break;
-            case NODE_BINARY_EXPR:
-                free_ast(node->data.binary_expr.left);
-                free_ast(node->data.binary_expr.right);
-                break;
-            case NODE_UNARY_EXPR:
-                free_ast(node->data.unary_expr.operand);
-            case NODE_STRING:
-                free(node->data.string.value);
-                break;
-            case NODE_VARIABLE:
-                free(node->data.variable.name);
-                break;
-            case NODE_VAR_DECLARATION:
-                free(node->data.var_declaration.name);
-                free_ast(node->data.var_declaration.init_expr);
-                break;
-            case NODE_ASSIGNMENT:
-                free(node->data.assignment.target);
-                free_ast(node->data.assignment.value);
-                break;
-            case NODE_RETURN:
-                free_ast(node->data.return_statement.expression);
-                break;
-            case NODE_NUMBER:
-            case NODE_FLOAT:
-            case NODE_CHAR:
-            case NODE_BOOL:
-                break;
-        }
-        if (node->next) free(node->next);
-        free(node);
+LogElement* create_log_element(NodeType type) {
+    LogElement* element = ast_alloc(sizeof(LogElement));
+    if (!element) {
+        parser_error("Memory allocation failed for log element");
+        return NULL;
     }
+    element->type = type;
+    element->var_type = TYPE_ZIL;
+    element->next = NULL;
+    return element;
+}
+
+// ==================== cleanup ====================
+
+void free_ast(void) {
+    TranspilerContext* ctx = current_context();
+
+    // nodes are never freed individually; dropping the arena releases the
+    // whole tree along with every interned identifier in one go
+    string_interner_destroy(ctx->strings);
+    arena_destroy(ctx->arena);
+    ctx->strings = NULL;
+    ctx->arena = NULL;
+    ctx->ast = NULL;
 }
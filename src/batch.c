@@ -0,0 +1,94 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "batch.h"
+#include "context.h"
+#include "output_path.h"
+
+// shared by all workers; files are handed out through next_input
+typedef struct {
+    const char** inputs;
+    int count;
+    const char* output_dir;
+    TranspileOptions options;
+    atomic_int next_input;
+    atomic_int failures;
+} BatchQueue;
+
+// ==================== internal helper functions ====================
+
+static void* batch_worker(void* arg) {
+    BatchQueue* queue = arg;
+
+    while (1) {
+        int index = atomic_fetch_add(&queue->next_input, 1);
+        if (index >= queue->count) break;
+
+        const char* input = queue->inputs[index];
+        char* output = output_path_for(queue->output_dir, input);
+        if (!output || !transpile_file(input, output, &queue->options)) {
+            atomic_fetch_add(&queue->failures, 1);
+        }
+        free(output);
+    }
+
+    return NULL;
+}
+
+// ==================== public API ====================
+
+int transpile_batch(const char** inputs, int count, const char* output_dir,
+                    int jobs, const TranspileOptions* options) {
+    BatchQueue queue = {
+        .inputs = inputs,
+        .count = count,
+        .output_dir = output_dir,
+        .options = *options
+    };
+    queue.options.qualify_errors = true;
+    atomic_init(&queue.next_input, 0);
+    atomic_init(&queue.failures, 0);
+
+    if (jobs <= 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        jobs = cpus > 0 ? (int)cpus : 1;
+    }
+    if (jobs > count) {
+        jobs = count;
+    }
+
+    // a single job runs on the calling thread
+    if (jobs <= 1) {
+        batch_worker(&queue);
+        return atomic_load(&queue.failures);
+    }
+
+    pthread_t* workers = malloc(sizeof(pthread_t) * jobs);
+    if (!workers) {
+        batch_worker(&queue);
+        return atomic_load(&queue.failures);
+    }
+
+    int started = 0;
+    for (int i = 0; i < jobs; i++) {
+        if (pthread_create(&workers[started], NULL, batch_worker, &queue) == 0) {
+            started++;
+        }
+    }
+
+    // if no thread could be started, do the work here instead
+    if (started == 0) {
+        batch_worker(&queue);
+    }
+
+    for (int i = 0; i < started; i++) {
+        pthread_join(workers[i], NULL);
+    }
+    free(workers);
+
+    return atomic_load(&queue.failures);
+}
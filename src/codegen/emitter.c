@@ -0,0 +1,279 @@
+#include "codegen/emitter.h"
+#include "codegen/c_syntax.h"
+#include "instrument.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#define BUFFER_CAPACITY (1024 * 1024)
+#define MMAP_INITIAL_CAPACITY (1024 * 1024)
+#define MEMORY_INITIAL_CAPACITY (64 * 1024)
+
+// indentation for the first 16 levels is sliced out of one constant string
+#define INDENT_4_LEVELS       C_INDENT C_INDENT C_INDENT C_INDENT
+#define INDENT_16_LEVELS      INDENT_4_LEVELS INDENT_4_LEVELS INDENT_4_LEVELS INDENT_4_LEVELS
+#define PRECOMPUTED_LEVELS    16
+
+static const char indent_spaces[] = INDENT_16_LEVELS;
+
+// ==================== internal helper functions ====================
+
+static bool write_all(int fd, const char* data, size_t len) {
+    while (len > 0) {
+        ssize_t written = write(fd, data, len);
+        if (written < 0) return false;
+        data += written;
+        len -= (size_t)written;
+    }
+    return true;
+}
+
+static bool map_output(Emitter* out, size_t new_capacity) {
+    if (ftruncate(out->fd, (off_t)new_capacity) != 0) return false;
+
+    if (out->data) {
+        munmap(out->data, out->capacity);
+    }
+
+    void* mapping = mmap(NULL, new_capacity, PROT_READ | PROT_WRITE, MAP_SHARED, out->fd, 0);
+    if (mapping == MAP_FAILED) {
+        out->data = NULL;
+        out->capacity = 0;
+        return false;
+    }
+
+    out->data = mapping;
+    out->capacity = new_capacity;
+    return true;
+}
+
+// make room for len more bytes; returns false once the emitter has failed
+static bool reserve(Emitter* out, size_t len) {
+    if (out->failed) return false;
+    if (out->length + len <= out->capacity) return true;
+
+    if (out->mode == EMITTER_BUFFERED) {
+        if (!emitter_flush(out)) return false;
+        if (len <= out->capacity) return true;
+    }
+
+    size_t new_capacity = out->capacity * 2;
+    if (new_capacity < out->length + len) {
+        new_capacity = out->length + len;
+    }
+
+    if (out->mode == EMITTER_MMAP) {
+        if (!map_output(out, new_capacity)) {
+            out->failed = true;
+            return false;
+        }
+        return true;
+    }
+
+    char* data = realloc(out->data, new_capacity);
+    if (!data) {
+        out->failed = true;
+        return false;
+    }
+    INSTRUMENT_ALLOC(MEM_EMITTER, new_capacity);
+    out->data = data;
+    out->capacity = new_capacity;
+    return true;
+}
+
+static Emitter* emitter_alloc(int fd, EmitterMode mode, size_t capacity) {
+    Emitter* out = malloc(sizeof(Emitter));
+    if (!out) return NULL;
+    INSTRUMENT_ALLOC(MEM_EMITTER, sizeof(Emitter));
+
+    out->data = NULL;
+    out->length = 0;
+    out->capacity = 0;
+    out->flushed = 0;
+    out->fd = fd;
+    out->mode = mode;
+    out->failed = false;
+
+    if (mode == EMITTER_MMAP) {
+        if (!map_output(out, capacity)) {
+            free(out);
+            return NULL;
+        }
+    } else {
+        out->data = malloc(capacity);
+        if (!out->data) {
+            free(out);
+            return NULL;
+        }
+        INSTRUMENT_ALLOC(MEM_EMITTER, capacity);
+        out->capacity = capacity;
+    }
+
+    return out;
+}
+
+// ==================== lifecycle ====================
+
+Emitter* emitter_open(const char* path, EmitterMode mode) {
+    // a mapping needs read access to the file as well
+    int flags = (mode == EMITTER_MMAP ? O_RDWR : O_WRONLY) | O_CREAT | O_TRUNC;
+    int fd = open(path, flags, 0644);
+    if (fd < 0) return NULL;
+
+    size_t capacity = mode == EMITTER_MMAP ? MMAP_INITIAL_CAPACITY : BUFFER_CAPACITY;
+    Emitter* out = emitter_alloc(fd, mode, capacity);
+    if (!out) {
+        close(fd);
+        return NULL;
+    }
+    return out;
+}
+
+Emitter* emitter_create_memory(void) {
+    return emitter_alloc(-1, EMITTER_MEMORY, MEMORY_INITIAL_CAPACITY);
+}
+
+void emitter_reset(Emitter* out) {
+    if (out->mode != EMITTER_MEMORY) return;
+
+    out->length = 0;
+    out->failed = false;
+}
+
+bool emitter_flush(Emitter* out) {
+    if (out->mode != EMITTER_BUFFERED || out->length == 0) return !out->failed;
+    if (out->failed) return false;
+
+    if (!write_all(out->fd, out->data, out->length)) {
+        out->failed = true;
+        return false;
+    }
+    out->flushed += out->length;
+    out->length = 0;
+    return true;
+}
+
+bool emitter_close(Emitter* out) {
+    if (!out) return false;
+
+    bool ok = emitter_flush(out);
+
+    if (out->mode == EMITTER_MMAP) {
+        if (out->data) {
+            munmap(out->data, out->capacity);
+        }
+        // drop the unused tail of the last mapping
+        if (ftruncate(out->fd, (off_t)out->length) != 0) {
+            ok = false;
+        }
+    } else {
+        free(out->data);
+    }
+
+    if (out->fd >= 0 && close(out->fd) != 0) {
+        ok = false;
+    }
+
+    ok = ok && !out->failed;
+    free(out);
+    return ok;
+}
+
+// ==================== writing ====================
+
+void emit_raw(Emitter* out, const char* data, size_t len) {
+    if (!reserve(out, len)) return;
+
+    memcpy(out->data + out->length, data, len);
+    out->length += len;
+}
+
+void emit_str(Emitter* out, const char* str) {
+    emit_raw(out, str, strlen(str));
+}
+
+void emit_char(Emitter* out, char c) {
+    if (!reserve(out, 1)) return;
+
+    out->data[out->length++] = c;
+}
+
+void emit_int(Emitter* out, int value) {
+    char digits[16];
+    size_t pos = sizeof(digits);
+    unsigned int magnitude = value < 0 ? 0u - (unsigned int)value : (unsigned int)value;
+
+    do {
+        digits[--pos] = (char)('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude > 0);
+
+    if (value < 0) {
+        digits[--pos] = '-';
+    }
+
+    emit_raw(out, digits + pos, sizeof(digits) - pos);
+}
+
+void emit_format(Emitter* out, const char* fmt, ...) {
+    char small[128];
+    va_list args;
+
+    va_start(args, fmt);
+    int len = vsnprintf(small, sizeof(small), fmt, args);
+    va_end(args);
+
+    if (len < 0) {
+        out->failed = true;
+        return;
+    }
+
+    if ((size_t)len < sizeof(small)) {
+        emit_raw(out, small, (size_t)len);
+        return;
+    }
+
+    // too long for the stack buffer: format straight into the output
+    if (!reserve(out, (size_t)len + 1)) return;
+
+    va_start(args, fmt);
+    vsnprintf(out->data + out->length, (size_t)len + 1, fmt, args);
+    va_end(args);
+    out->length += (size_t)len;
+}
+
+void emit_indent(Emitter* out, int level) {
+    while (level > PRECOMPUTED_LEVELS) {
+        emit_raw(out, indent_spaces, sizeof(indent_spaces) - 1);
+        level -= PRECOMPUTED_LEVELS;
+    }
+    if (level > 0) {
+        emit_raw(out, indent_spaces, (size_t)level * C_INDENT_SIZE);
+    }
+}
+
+void emit_escaped(Emitter* out, const char* str) {
+    const char* run = str;
+
+    for (const char* p = str; *p; p++) {
+        const char* escape;
+        switch (*p) {
+            case '\n': escape = C_ESC_NEWLINE; break;
+            case '\t': escape = C_ESC_TAB; break;
+            case '\"': escape = C_ESC_QUOTE; break;
+            case '\\': escape = C_ESC_BACKSLASH; break;
+            default: continue;
+        }
+
+        // copy everything up to the special character in one go
+        emit_raw(out, run, (size_t)(p - run));
+        emit_str(out, escape);
+        run = p + 1;
+    }
+
+    emit_str(out, run);
+}
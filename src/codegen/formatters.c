@@ -5,86 +5,120 @@
 #include <stdbool.h>
 #include <stdio.h>
 
-// ==================== mangling helper ====================
+// ==================== identifiers ====================
 
-static const char* mangle_identifier(const char* w_name, bool is_function) {
+void emit_identifier(Emitter* out, const char* w_name, bool is_function) {
     // Special case: entry point w() becomes main
-    if (strcmp(w_name, "w") == 0 && is_function) {
-        return C_MAIN;
+    if (is_function && strcmp(w_name, "w") == 0) {
+        emit_lit(out, C_MAIN);
+        return;
     }
 
-    // Mangle: W__name_v (variables) or W__name_f (functions)
-    static char buffer[512];
-    snprintf(buffer, sizeof(buffer), "W__%s_%c", w_name, is_function ? 'f' : 'v');
-    return buffer;
+    // Mangle: W__name_v (variables) or W__name_f (functions), written piece
+    // by piece so no shared scratch buffer is needed
+    emit_lit(out, "W__");
+    emit_str(out, w_name);
+    if (is_function) {
+        emit_lit(out, "_f");
+    } else {
+        emit_lit(out, "_v");
+    }
 }
 
 // ==================== output helpers ====================
 
-void emit_indent(FILE* out, int level) {
-    for (int i = 0; i < level; i++) {
-        fprintf(out, C_INDENT);
-    }
-}
-
-void emit_c_includes(FILE* out) {
-    fprintf(out, C_INCLUDES_BLOCK);
+void emit_c_includes(Emitter* out) {
+    emit_lit(out, C_INCLUDES_BLOCK);
 }
 
 // ==================== function generation ====================
 
-void emit_function_signature(FILE* out, const char* return_type, const char* name,
+void emit_function_signature(Emitter* out, const char* return_type, const char* name,
                              Parameter* params, int param_count) {
-    fprintf(out, "%s %s" C_LPAREN, return_type, name);
+    emit_str(out, return_type);
+    emit_lit(out, C_SPACE);
+    emit_identifier(out, name, true);
+    emit_lit(out, C_LPAREN);
 
     if (param_count == 0) {
-        fprintf(out, C_VOID);
+        emit_lit(out, C_VOID);
     } else {
         Parameter* param = params;
         bool first = true;
         while (param) {
             if (!first) {
-                fprintf(out, C_COMMA);
+                emit_lit(out, C_COMMA);
             }
-            fprintf(out, "%s %s", get_c_type_from_enum(param->type),
-                    mangle_identifier(param->name, false));
+            emit_str(out, get_c_type_from_enum(param->type));
+            emit_lit(out, C_SPACE);
+            emit_identifier(out, param->name, false);
             first = false;
             param = param->next;
         }
     }
 
-    fprintf(out, C_RPAREN C_LBRACE);
+    emit_lit(out, C_RPAREN C_LBRACE);
+}
+
+void emit_function_linkage(Emitter* out, const ASTNode* function) {
+    switch (function->data.function.linkage) {
+        case LINKAGE_STATIC:
+            emit_lit(out, C_STATIC C_SPACE);
+            break;
+        case LINKAGE_INLINE:
+            emit_lit(out, C_STATIC C_SPACE C_INLINE C_SPACE);
+            break;
+        default:
+            break;
+    }
+
+    switch (function->data.function.hotness) {
+        case HOTNESS_HOT:
+            emit_lit(out, C_ATTRIBUTE_HOT C_SPACE);
+            break;
+        case HOTNESS_COLD:
+            emit_lit(out, C_ATTRIBUTE_COLD C_SPACE);
+            break;
+        default:
+            break;
+    }
 }
 
-void emit_function_declaration(FILE* out, const char* return_type, const char* name,
+void emit_function_declaration(Emitter* out, const char* return_type, const char* name,
                                 Parameter* params, int param_count) {
-    fprintf(out, "%s %s" C_LPAREN, return_type, name);
+    emit_str(out, return_type);
+    emit_lit(out, C_SPACE);
+    emit_identifier(out, name, true);
+    emit_lit(out, C_LPAREN);
 
     if (param_count == 0) {
-        fprintf(out, C_VOID);
+        emit_lit(out, C_VOID);
     } else {
         Parameter* param = params;
         bool first = true;
         while (param) {
             if (!first) {
-                fprintf(out, C_COMMA);
+                emit_lit(out, C_COMMA);
             }
-            fprintf(out, "%s %s", get_c_type_from_enum(param->type),
-                    mangle_identifier(param->name, false));
+            emit_str(out, get_c_type_from_enum(param->type));
+            emit_lit(out, C_SPACE);
+            emit_identifier(out, param->name, false);
             first = false;
             param = param->next;
         }
     }
 
-    fprintf(out, C_RPAREN C_SEMICOLON_NL);
+    emit_lit(out, C_RPAREN C_SEMICOLON_NL);
 }
 
 // ==================== type conversion ====================
 
-void emit_cast(FILE* out, DataType from_type, DataType to_type) {
+void emit_cast(Emitter* out, DataType from_type, DataType to_type) {
     if (from_type == to_type) return;
 
-    fprintf(out, C_LPAREN "%s" C_RPAREN, get_c_type_from_enum(to_type));
+    emit_lit(out, C_LPAREN);
+    emit_str(out, get_c_type_from_enum(to_type));
+    emit_lit(out, C_RPAREN);
 }
 
 // ==================== operator formatting ====================
@@ -0,0 +1,234 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+
+#include "context.h"
+#include "parser.h"
+#include "semantic.h"
+#include "optimize.h"
+#include "source.h"
+#include "gen.h"
+#include "instrument.h"
+
+// set while a compilation runs; parser, AST and symbol table code reach their
+// state through it instead of through globals
+static _Thread_local TranspilerContext* active_context = NULL;
+
+// ==================== lifecycle ====================
+
+TranspilerContext* context_create(const char* input_name) {
+    TranspilerContext* ctx = calloc(1, sizeof(TranspilerContext));
+    if (!ctx) return NULL;
+
+    if (yylex_init(&ctx->scanner) != 0) {
+        free(ctx);
+        return NULL;
+    }
+
+    ctx->input_name = input_name;
+    ctx->diagnostics = stderr;
+    active_context = ctx;
+
+    if (!init_ast()) {
+        context_destroy(ctx);
+        return NULL;
+    }
+    init_parser();
+    return ctx;
+}
+
+void context_configure(TranspilerContext* ctx, const TranspileOptions* options) {
+    ctx->qualify_errors = options->qualify_errors;
+    ctx->report_removed = options->report_removed;
+    ctx->whole_program = options->whole_program || options->hot_cold;
+    ctx->hot_cold = options->hot_cold;
+
+    if (options->cache_dir && !ctx->cache) {
+        // a cache that cannot be opened only costs speed
+        ctx->cache = function_cache_open(options->cache_dir);
+        if (!ctx->cache) {
+            fprintf(ctx->diagnostics, "Warning: cannot use cache directory '%s': %s\n",
+                    options->cache_dir, strerror(errno));
+        }
+    }
+}
+
+void context_reset(TranspilerContext* ctx, const char* input_name) {
+    active_context = ctx;
+
+    // scopes are small and rebuilt; the arena, interner table and scanner
+    // keep their memory for the next input
+    cleanup_parser();
+    string_interner_clear(ctx->strings);
+    arena_rewind(ctx->arena);
+    lexer_reset(ctx->scanner);
+
+    ctx->ast = NULL;
+    ctx->input_name = input_name;
+    init_parser();
+}
+
+void context_destroy(TranspilerContext* ctx) {
+    if (!ctx) return;
+
+    active_context = ctx;
+    free_ast();
+    cleanup_parser();
+    function_cache_close(ctx->cache);
+    if (ctx->scratch) {
+        emitter_close(ctx->scratch);
+    }
+    yylex_destroy(ctx->scanner);
+    free(ctx);
+    active_context = NULL;
+}
+
+TranspilerContext* current_context(void) {
+    return active_context;
+}
+
+int context_line(TranspilerContext* ctx) {
+    return yyget_lineno(ctx->scanner);
+}
+
+void context_abort(TranspilerContext* ctx) {
+    longjmp(ctx->abort_point, 1);
+}
+
+// ==================== driver ====================
+
+typedef struct {
+    double wall;
+    double cpu;
+} PhaseClock;
+
+static void clock_start(PhaseClock* clock) {
+    if (!instrument_timing) return;
+
+    clock->wall = instrument_wall_time();
+    clock->cpu = instrument_cpu_time();
+}
+
+// charge the time since the last lap to a phase and start the next one. the
+// lexer runs inside parse(), timed token by token in context_advance; it gets
+// its own line, with a share of the CPU time in proportion to its wall time.
+static void clock_lap(PhaseClock* clock, Phase phase, double lexing) {
+    if (!instrument_timing) return;
+
+    double wall = instrument_wall_time();
+    double cpu = instrument_cpu_time();
+    double phase_wall = wall - clock->wall;
+    double phase_cpu = cpu - clock->cpu;
+
+    if (lexing > 0 && phase_wall > 0) {
+        double lex_cpu = phase_cpu * (lexing / phase_wall);
+        instrument_add_phase(PHASE_LEX, lexing, lex_cpu);
+        phase_wall -= lexing;
+        phase_cpu -= lex_cpu;
+    }
+    instrument_add_phase(phase, phase_wall, phase_cpu);
+
+    clock->wall = wall;
+    clock->cpu = cpu;
+}
+
+void context_advance(TranspilerContext* ctx) {
+    if (!instrument_timing) {
+        ctx->token = yylex(&ctx->lval, ctx->scanner);
+        return;
+    }
+
+    double start = instrument_wall_time();
+    ctx->token = yylex(&ctx->lval, ctx->scanner);
+    ctx->lex_seconds += instrument_wall_time() - start;
+}
+
+// fatal errors land back here
+bool context_run(TranspilerContext* ctx, SourceFile* input, Emitter* output) {
+    active_context = ctx;
+    if (setjmp(ctx->abort_point) != 0) {
+        return false;
+    }
+
+    if (!source_attach_lexer(input, ctx->scanner)) {
+        fprintf(ctx->diagnostics, "Failed to initialize lexer input.\n");
+        return false;
+    }
+
+    PhaseClock clock;
+    clock_start(&clock);
+    ctx->lex_seconds = 0;
+
+    context_advance(ctx);
+    ctx->ast = parse();
+    clock_lap(&clock, PHASE_PARSE, ctx->lex_seconds);
+
+    if (!ctx->ast || ctx->ast->type != NODE_PROGRAM) {
+        fprintf(ctx->diagnostics, "Failed to parse program.\n");
+        return false;
+    }
+
+    // unchanged functions pick up their generated C and skip the later passes
+    function_cache_lookup_program(ctx->cache, ctx->ast);
+
+    // type errors used to stop the parser; generating from them gives invalid C.
+    // the parser's own errors below the abort limit fail the run just the same,
+    // after the semantic pass has had its say
+    if (!annotate_program(ctx->ast) || ctx->parser_state.error_count > 0) {
+        return false;
+    }
+    fold_program(ctx->ast);
+    eliminate_dead_functions(ctx->ast);
+    if (ctx->whole_program) {
+        plan_whole_program(ctx->ast);
+    }
+    clock_lap(&clock, PHASE_SEMANTIC, 0);
+
+    generate_code(output, ctx->ast);
+    clock_lap(&clock, PHASE_GENERATE, 0);
+
+    // both reports print the file count
+    if (instrument_timing || instrument_memory) {
+        instrument_count_file();
+    }
+    return true;
+}
+
+bool transpile_file(const char* input_name, const char* output_name,
+                    const TranspileOptions* options) {
+    SourceFile input;
+    if (!source_open(&input, input_name)) {
+        fprintf(stderr, "Error opening input file '%s': %s\n", input_name, strerror(errno));
+        return false;
+    }
+
+    Emitter* output = emitter_open(output_name, options->mode);
+    if (!output) {
+        fprintf(stderr, "Error opening output file '%s': %s\n", output_name, strerror(errno));
+        source_close(&input);
+        return false;
+    }
+
+    bool ok = false;
+    TranspilerContext* ctx = context_create(input_name);
+    if (ctx) {
+        context_configure(ctx, options);
+        ok = context_run(ctx, &input, output);
+        context_destroy(ctx);
+    } else {
+        fprintf(stderr, "Failed to initialize transpiler context.\n");
+    }
+
+    source_close(&input);
+    if (!emitter_close(output) && ok) {
+        fprintf(stderr, "Error writing output file '%s': %s\n", output_name, strerror(errno));
+        ok = false;
+    }
+
+    if (!ok) {
+        unlink(output_name);
+    }
+    return ok;
+}
@@ -0,0 +1,309 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <signal.h>
+#include <unistd.h>
+
+#include "daemon/protocol.h"
+#include "output_path.h"
+
+// thin front end for `transpiler --serve`: same command line as the
+// transpiler itself, but every file is compiled by the warm server process.
+// --mmap-output, --cache-dir and the report flags (--time-report,
+// --mem-report, --report-format) are accepted for compatibility; those are
+// settings of the server, which prints its reports when it exits.
+
+#define READ_CHUNK_SIZE (64 * 1024)
+
+typedef struct {
+    const char* socket_path;
+    const char** inputs;
+    const char* output_dir;         // NULL for the single input.w output.c form
+    const char* output_name;
+    int count;
+    uint32_t flags;                 // RequestFlags from the command line
+    atomic_int next_input;
+    atomic_int failures;
+} ClientQueue;
+
+// ==================== internal helper functions ====================
+
+static void print_usage(const char* program) {
+    fprintf(stderr, "Usage: %s [--server SOCKET] [options] input.w output.c\n", program);
+    fprintf(stderr, "       %s [--server SOCKET] [options] [-j N] -o outdir/ input.w...\n", program);
+    fprintf(stderr, "Options: --report-removed, --whole-program, --hot-cold\n");
+    fprintf(stderr, "Ignored (server settings): --mmap-output, --cache-dir DIR, --time-report,\n");
+    fprintf(stderr, "    --mem-report, --report-format table|json\n");
+    fprintf(stderr, "The socket defaults to $%s.\n", PROTOCOL_SOCKET_ENV);
+}
+
+// read a whole file (or pipe) into memory
+static char* read_source(const char* path, size_t* length) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return NULL;
+
+    size_t capacity = READ_CHUNK_SIZE;
+    size_t size = 0;
+    char* data = malloc(capacity);
+    while (data) {
+        if (size == capacity) {
+            capacity *= 2;
+            char* grown = realloc(data, capacity);
+            if (!grown) {
+                free(data);
+                data = NULL;
+                break;
+            }
+            data = grown;
+        }
+
+        ssize_t got = read(fd, data + size, capacity - size);
+        if (got < 0 && errno == EINTR) continue;
+        if (got < 0) {
+            free(data);
+            data = NULL;
+        } else if (got == 0) {
+            break;
+        } else {
+            size += (size_t)got;
+        }
+    }
+
+    int saved = errno;
+    close(fd);
+    errno = saved;
+    *length = size;
+    return data;
+}
+
+static bool write_output(const char* path, const char* data, size_t length) {
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return false;
+
+    bool ok = protocol_write_all(fd, data, length);
+    return close(fd) == 0 && ok;
+}
+
+// send one file to the server and write what comes back
+// returns: false if the file failed; *connection_lost is set when the
+// connection can no longer be used
+static bool transpile_remote(int fd, const char* input, const char* output, uint32_t flags,
+                             bool* connection_lost) {
+    size_t source_length;
+    char* source = read_source(input, &source_length);
+    if (!source) {
+        fprintf(stderr, "Error opening input file '%s': %s\n", input, strerror(errno));
+        return false;
+    }
+
+    RequestHeader request = {
+        .magic = PROTOCOL_MAGIC,
+        .version = PROTOCOL_VERSION,
+        .flags = flags,
+        .name_length = (uint32_t)strlen(input),
+        .source_length = source_length
+    };
+    ResponseHeader response;
+    bool exchanged = protocol_write_all(fd, &request, sizeof(request)) &&
+                     protocol_write_all(fd, input, request.name_length) &&
+                     protocol_write_all(fd, source, source_length) &&
+                     protocol_read_all(fd, &response, sizeof(response)) &&
+                     response.magic == PROTOCOL_MAGIC;
+    free(source);
+
+    char* code = NULL;
+    char* diagnostics = NULL;
+    if (exchanged) {
+        code = malloc(response.output_length + 1);
+        diagnostics = malloc(response.diagnostics_length + 1);
+        exchanged = code && diagnostics &&
+                    protocol_read_all(fd, code, response.output_length) &&
+                    protocol_read_all(fd, diagnostics, response.diagnostics_length);
+    }
+    if (!exchanged) {
+        fprintf(stderr, "Lost connection to server while transpiling '%s'\n", input);
+        free(code);
+        free(diagnostics);
+        *connection_lost = true;
+        return false;
+    }
+
+    // one write, so diagnostics of parallel files do not interleave
+    fwrite(diagnostics, 1, response.diagnostics_length, stderr);
+
+    bool ok = response.status == RESPONSE_OK;
+    if (ok && !write_output(output, code, response.output_length)) {
+        fprintf(stderr, "Error writing output file '%s': %s\n", output, strerror(errno));
+        ok = false;
+    }
+    if (!ok) {
+        // a failed compilation leaves no output file
+        unlink(output);
+    }
+
+    free(code);
+    free(diagnostics);
+    return ok;
+}
+
+static void* client_worker(void* arg) {
+    ClientQueue* queue = arg;
+
+    int fd = protocol_connect(queue->socket_path);
+    if (fd < 0) {
+        fprintf(stderr, "Error connecting to '%s': %s\n", queue->socket_path, strerror(errno));
+    }
+
+    // batch diagnostics name their file, as in the transpiler's batch mode
+    uint32_t flags = queue->flags;
+    if (queue->output_dir) {
+        flags |= REQUEST_QUALIFY_ERRORS;
+    }
+    bool connection_lost = fd < 0;
+
+    while (1) {
+        int index = atomic_fetch_add(&queue->next_input, 1);
+        if (index >= queue->count) break;
+
+        const char* input = queue->inputs[index];
+        char* output = queue->output_dir ? output_path_for(queue->output_dir, input)
+                                         : (char*)queue->output_name;
+        if (connection_lost || !output ||
+            !transpile_remote(fd, input, output, flags, &connection_lost)) {
+            atomic_fetch_add(&queue->failures, 1);
+        }
+        if (queue->output_dir) {
+            free(output);
+        }
+    }
+
+    if (fd >= 0) {
+        close(fd);
+    }
+    return NULL;
+}
+
+// ==================== main ====================
+
+int main(int argc, char* argv[]) {
+    const char* socket_path = getenv(PROTOCOL_SOCKET_ENV);
+    const char* output_dir = NULL;
+    int jobs = 0;
+    bool jobs_given = false;
+    uint32_t flags = 0;
+
+    const char** inputs = malloc(sizeof(char*) * (argc > 1 ? argc : 1));
+    int input_count = 0;
+    if (!inputs) {
+        perror("Error allocating arguments");
+        return 1;
+    }
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--server") == 0 && i + 1 < argc) {
+            socket_path = argv[++i];
+        } else if (strcmp(argv[i], "--mmap-output") == 0) {
+            // the server decides how output is produced
+        } else if (strcmp(argv[i], "--cache-dir") == 0 && i + 1 < argc) {
+            i++;
+        } else if (strcmp(argv[i], "--time-report") == 0 ||
+                   strcmp(argv[i], "--mem-report") == 0) {
+            // the server counts and reports
+        } else if (strcmp(argv[i], "--report-format") == 0 && i + 1 < argc) {
+            const char* value = argv[++i];
+            if (strcmp(value, "json") != 0 && strcmp(value, "table") != 0) {
+                fprintf(stderr, "Unknown report format: %s\n", value);
+                free(inputs);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--report-removed") == 0) {
+            flags |= REQUEST_REPORT_REMOVED;
+        } else if (strcmp(argv[i], "--whole-program") == 0) {
+            flags |= REQUEST_WHOLE_PROGRAM;
+        } else if (strcmp(argv[i], "--hot-cold") == 0) {
+            flags |= REQUEST_HOT_COLD;
+        } else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            output_dir = argv[++i];
+        } else if (strncmp(argv[i], "-j", 2) == 0) {
+            const char* value = argv[i][2] ? argv[i] + 2 : (i + 1 < argc ? argv[++i] : "");
+            char* end;
+            long parsed = strtol(value, &end, 10);
+            if (*value == '\0' || *end != '\0' || parsed < 1) {
+                fprintf(stderr, "Invalid job count: %s\n", value);
+                free(inputs);
+                return 1;
+            }
+            jobs = (int)parsed;
+            jobs_given = true;
+        } else if (argv[i][0] == '-' && argv[i][1] != '\0') {
+            fprintf(stderr, "Unknown option: %s\n", argv[i]);
+            print_usage(argv[0]);
+            free(inputs);
+            return 1;
+        } else {
+            inputs[input_count++] = argv[i];
+        }
+    }
+
+    bool batch = output_dir != NULL;
+    if (!socket_path || (batch && input_count == 0) ||
+        (!batch && (input_count != 2 || jobs_given))) {
+        print_usage(argv[0]);
+        free(inputs);
+        return 1;
+    }
+
+    // checked before any worker starts: two writers of one file would race
+    if (batch && !output_paths_distinct(output_dir, inputs, input_count)) {
+        free(inputs);
+        return 1;
+    }
+
+    ClientQueue queue = {
+        .socket_path = socket_path,
+        .inputs = inputs,
+        .output_dir = output_dir,
+        .output_name = batch ? NULL : inputs[1],
+        .count = batch ? input_count : 1,
+        .flags = flags
+    };
+    atomic_init(&queue.next_input, 0);
+    atomic_init(&queue.failures, 0);
+
+    if (jobs <= 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        jobs = cpus > 0 ? (int)cpus : 1;
+    }
+    if (jobs > queue.count) {
+        jobs = queue.count;
+    }
+
+    // a server that goes away mid-request is reported, not fatal
+    signal(SIGPIPE, SIG_IGN);
+
+    // every extra job is another connection, served by its own server thread
+    pthread_t* workers = malloc(sizeof(pthread_t) * jobs);
+    int started = 0;
+    for (int i = 1; workers && i < jobs; i++) {
+        if (pthread_create(&workers[started], NULL, client_worker, &queue) == 0) {
+            started++;
+        }
+    }
+    client_worker(&queue);
+    for (int i = 0; i < started; i++) {
+        pthread_join(workers[i], NULL);
+    }
+    free(workers);
+
+    int failures = atomic_load(&queue.failures);
+    if (batch && failures > 0) {
+        fprintf(stderr, "%d of %d files failed\n", failures, input_count);
+    }
+
+    free(inputs);
+    return failures > 0 ? 1 : 0;
+}
@@ -0,0 +1,51 @@
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "daemon/protocol.h"
+
+bool protocol_read_all(int fd, void* data, size_t len) {
+    char* bytes = data;
+    while (len > 0) {
+        ssize_t got = read(fd, bytes, len);
+        if (got < 0 && errno == EINTR) continue;
+        if (got <= 0) return false;
+        bytes += got;
+        len -= (size_t)got;
+    }
+    return true;
+}
+
+bool protocol_write_all(int fd, const void* data, size_t len) {
+    const char* bytes = data;
+    while (len > 0) {
+        ssize_t written = write(fd, bytes, len);
+        if (written < 0 && errno == EINTR) continue;
+        if (written < 0) return false;
+        bytes += written;
+        len -= (size_t)written;
+    }
+    return true;
+}
+
+int protocol_connect(const char* socket_path) {
+    struct sockaddr_un addr = { .sun_family = AF_UNIX };
+    if (strlen(socket_path) >= sizeof(addr.sun_path)) {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+    strcpy(addr.sun_path, socket_path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+
+    if (connect(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+        int saved = errno;
+        close(fd);
+        errno = saved;
+        return -1;
+    }
+    return fd;
+}
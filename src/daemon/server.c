@@ -0,0 +1,247 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+#include "daemon/server.h"
+#include "daemon/protocol.h"
+
+static volatile sig_atomic_t stop_requested = 0;
+
+typedef struct {
+    int fd;
+    const TranspileOptions* options;
+} Connection;
+
+// ==================== internal helper functions ====================
+
+static void handle_stop(int signal_number) {
+    (void)signal_number;
+    stop_requested = 1;
+}
+
+static bool send_response(int fd, ResponseStatus status, const char* output, size_t output_length,
+                          const char* diagnostics, size_t diagnostics_length) {
+    ResponseHeader header = {
+        .magic = PROTOCOL_MAGIC,
+        .status = status,
+        .output_length = output_length,
+        .diagnostics_length = diagnostics_length
+    };
+    return protocol_write_all(fd, &header, sizeof(header)) &&
+           protocol_write_all(fd, output, output_length) &&
+           protocol_write_all(fd, diagnostics, diagnostics_length);
+}
+
+static bool send_bad_request(int fd, const char* message) {
+    return send_response(fd, RESPONSE_BAD_REQUEST, NULL, 0, message, strlen(message));
+}
+
+// compile one in-memory source on the connection's context
+static bool compile_request(TranspilerContext** ctx, const char* name, char* source, size_t length,
+                            const TranspileOptions* options, Emitter* output, FILE* diagnostics) {
+    if (*ctx) {
+        context_reset(*ctx, name);
+    } else if (!(*ctx = context_create(name))) {
+        fprintf(diagnostics, "Failed to initialize transpiler context.\n");
+        return false;
+    }
+
+    (*ctx)->diagnostics = diagnostics;
+    context_configure(*ctx, options);
+
+    SourceFile input;
+    source_from_memory(&input, source, length);
+    bool ok = context_run(*ctx, &input, output) && !output->failed;
+
+    // the name and source are released after this request
+    (*ctx)->diagnostics = stderr;
+    (*ctx)->input_name = NULL;
+    return ok;
+}
+
+// read, compile and answer one request
+// returns: false when the connection should be closed
+static bool handle_request(TranspilerContext** ctx, int fd, const TranspileOptions* defaults) {
+    RequestHeader header;
+    if (!protocol_read_all(fd, &header, sizeof(header))) {
+        return false;
+    }
+
+    if (header.magic != PROTOCOL_MAGIC || header.version != PROTOCOL_VERSION) {
+        send_bad_request(fd, "Unsupported protocol version.\n");
+        return false;
+    }
+    if (header.name_length > PROTOCOL_MAX_NAME || header.source_length > PROTOCOL_MAX_SOURCE) {
+        send_bad_request(fd, "Request too large.\n");
+        return false;
+    }
+
+    // flex scans the source in place and needs two NUL bytes after it
+    char* name = malloc(header.name_length + 1);
+    char* source = malloc(header.source_length + 2);
+    if (!name || !source ||
+        !protocol_read_all(fd, name, header.name_length) ||
+        !protocol_read_all(fd, source, header.source_length)) {
+        free(name);
+        free(source);
+        return false;
+    }
+    name[header.name_length] = '\0';
+    source[header.source_length] = '\0';
+    source[header.source_length + 1] = '\0';
+
+    TranspileOptions options = *defaults;
+    options.qualify_errors = (header.flags & REQUEST_QUALIFY_ERRORS) != 0;
+    // the rest add to what the server was started with
+    options.report_removed |= (header.flags & REQUEST_REPORT_REMOVED) != 0;
+    options.whole_program |= (header.flags & REQUEST_WHOLE_PROGRAM) != 0;
+    options.hot_cold |= (header.flags & REQUEST_HOT_COLD) != 0;
+
+    char* diagnostics = NULL;
+    size_t diagnostics_length = 0;
+    FILE* diagnostics_stream = open_memstream(&diagnostics, &diagnostics_length);
+    Emitter* output = emitter_create_memory();
+
+    bool ok = false;
+    if (diagnostics_stream && output) {
+        ok = compile_request(ctx, name, source, header.source_length, &options,
+                             output, diagnostics_stream);
+    }
+    if (diagnostics_stream) {
+        fclose(diagnostics_stream);
+    }
+
+    bool sent;
+    if (!diagnostics_stream || !output) {
+        static const char out_of_memory[] = "Out of memory.\n";
+        sent = send_response(fd, RESPONSE_FAILED, NULL, 0, out_of_memory, sizeof(out_of_memory) - 1);
+    } else {
+        sent = send_response(fd, ok ? RESPONSE_OK : RESPONSE_FAILED,
+                             output->data, ok ? output->length : 0,
+                             diagnostics, diagnostics_length);
+    }
+
+    if (output) {
+        emitter_close(output);
+    }
+    free(diagnostics);
+    free(source);
+    free(name);
+    return sent;
+}
+
+static void* connection_worker(void* arg) {
+    Connection* connection = arg;
+
+    // one warm context per connection, reset between its requests
+    TranspilerContext* ctx = NULL;
+    while (handle_request(&ctx, connection->fd, connection->options)) {
+    }
+
+    context_destroy(ctx);
+    close(connection->fd);
+    free(connection);
+    return NULL;
+}
+
+// bind the socket, replacing a stale one left by a server that died
+static int open_listener(const char* socket_path) {
+    struct sockaddr_un addr = { .sun_family = AF_UNIX };
+    if (strlen(socket_path) >= sizeof(addr.sun_path)) {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+    strcpy(addr.sun_path, socket_path);
+
+    struct stat st;
+    if (lstat(socket_path, &st) == 0) {
+        if (!S_ISSOCK(st.st_mode)) {
+            errno = EEXIST;
+            return -1;
+        }
+        int probe = protocol_connect(socket_path);
+        if (probe >= 0) {
+            // another server is alive on this path
+            close(probe);
+            errno = EADDRINUSE;
+            return -1;
+        }
+        unlink(socket_path);
+    }
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+
+    if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 || listen(fd, SOMAXCONN) != 0) {
+        int saved = errno;
+        close(fd);
+        errno = saved;
+        return -1;
+    }
+    return fd;
+}
+
+// ==================== public API ====================
+
+bool serve(const char* socket_path, const TranspileOptions* options) {
+    int listener = open_listener(socket_path);
+    if (listener < 0) {
+        fprintf(stderr, "Error listening on '%s': %s\n", socket_path, strerror(errno));
+        return false;
+    }
+
+    // no SA_RESTART, so a stop signal interrupts accept()
+    struct sigaction stop = { .sa_handler = handle_stop };
+    sigemptyset(&stop.sa_mask);
+    sigaction(SIGINT, &stop, NULL);
+    sigaction(SIGTERM, &stop, NULL);
+    signal(SIGPIPE, SIG_IGN);
+
+    // workers inherit a mask that leaves the stop signals to this thread
+    sigset_t stop_signals, previous;
+    sigemptyset(&stop_signals);
+    sigaddset(&stop_signals, SIGINT);
+    sigaddset(&stop_signals, SIGTERM);
+
+    pthread_attr_t detached;
+    pthread_attr_init(&detached);
+    pthread_attr_setdetachstate(&detached, PTHREAD_CREATE_DETACHED);
+
+    while (!stop_requested) {
+        int fd = accept(listener, NULL, NULL);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            fprintf(stderr, "Error accepting connection: %s\n", strerror(errno));
+            break;
+        }
+
+        Connection* connection = malloc(sizeof(Connection));
+        if (!connection) {
+            close(fd);
+            continue;
+        }
+        connection->fd = fd;
+        connection->options = options;
+
+        pthread_t worker;
+        pthread_sigmask(SIG_BLOCK, &stop_signals, &previous);
+        int created = pthread_create(&worker, &detached, connection_worker, connection);
+        pthread_sigmask(SIG_SETMASK, &previous, NULL);
+        if (created != 0) {
+            close(fd);
+            free(connection);
+        }
+    }
+
+    pthread_attr_destroy(&detached);
+    close(listener);
+    unlink(socket_path);
+    return true;
+}
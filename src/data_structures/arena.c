@@ -0,0 +1,109 @@
+#include "data_structures/arena.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdalign.h>
+
+#define DEFAULT_CHUNK_SIZE (64 * 1024)
+#define ARENA_ALIGNMENT alignof(max_align_t)
+
+// ==================== internal helper functions ====================
+
+static size_t align_up(size_t value) {
+    return (value + ARENA_ALIGNMENT - 1) & ~(ARENA_ALIGNMENT - 1);
+}
+
+static ArenaChunk* chunk_create(size_t capacity) {
+    ArenaChunk* chunk = malloc(sizeof(ArenaChunk) + capacity);
+    if (!chunk) return NULL;
+
+    chunk->next = NULL;
+    chunk->capacity = capacity;
+    chunk->used = 0;
+    return chunk;
+}
+
+// ==================== core API implementation ====================
+
+Arena* arena_create(size_t chunk_size) {
+    Arena* arena = malloc(sizeof(Arena));
+    if (!arena) return NULL;
+
+    arena->head = NULL;
+    arena->chunk_size = chunk_size ? chunk_size : DEFAULT_CHUNK_SIZE;
+    arena->total_allocated = 0;
+    return arena;
+}
+
+void* arena_alloc(Arena* arena, size_t size) {
+    if (!arena) return NULL;
+
+    size = align_up(size ? size : 1);
+
+    ArenaChunk* chunk = arena->head;
+    if (!chunk || chunk->capacity - chunk->used < size) {
+        // oversized requests get a dedicated chunk so the default size stays small
+        size_t capacity = size > arena->chunk_size ? size : arena->chunk_size;
+        chunk = chunk_create(capacity);
+        if (!chunk) return NULL;
+
+        chunk->next = arena->head;
+        arena->head = chunk;
+    }
+
+    void* ptr = chunk->data + chunk->used;
+    chunk->used += size;
+    arena->total_allocated += size;
+    return ptr;
+}
+
+void* arena_calloc(Arena* arena, size_t count, size_t size) {
+    void* ptr = arena_alloc(arena, count * size);
+    if (ptr) {
+        memset(ptr, 0, count * size);
+    }
+    return ptr;
+}
+
+char* arena_strndup(Arena* arena, const char* str, size_t len) {
+    char* copy = arena_alloc(arena, len + 1);
+    if (!copy) return NULL;
+
+    memcpy(copy, str, len);
+    copy[len] = '\0';
+    return copy;
+}
+
+void arena_reset(Arena* arena) {
+    if (!arena) return;
+
+    ArenaChunk* chunk = arena->head;
+    while (chunk) {
+        ArenaChunk* next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
+    arena->head = NULL;
+    arena->total_allocated = 0;
+}
+
+void arena_rewind(Arena* arena) {
+    if (!arena || !arena->head) return;
+
+    ArenaChunk* keep = arena->head;
+    ArenaChunk* chunk = keep->next;
+    while (chunk) {
+        ArenaChunk* next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
+    keep->next = NULL;
+    keep->used = 0;
+    arena->total_allocated = 0;
+}
+
+void arena_destroy(Arena* arena) {
+    if (!arena) return;
+
+    arena_reset(arena);
+    free(arena);
+}
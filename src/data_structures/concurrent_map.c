@@ -0,0 +1,148 @@
+#include "data_structures/concurrent_map.h"
+#include <stdlib.h>
+#include <assert.h>
+
+// ==================== internal helper functions ====================
+
+// the shard of a hash, with the hash itself for the shard's map
+static CMapShard* shard_for(ConcurrentMap* cmap, const void* key, uint64_t* hash) {
+    // every shard hashes alike, so any of them can compute it
+    *hash = map_hash_key(cmap->shards[0].map, key);
+    return &cmap->shards[cmap->shard_count > 1 ? *hash >> cmap->shard_shift : 0];
+}
+
+static void destroy_shards(ConcurrentMap* cmap, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        pthread_rwlock_destroy(&cmap->shards[i].lock);
+        map_destroy(cmap->shards[i].map);
+    }
+    free(cmap->shards);
+}
+
+// ==================== core API implementation ====================
+
+ConcurrentMap* cmap_create(size_t shard_count, size_t initial_capacity, MapConfig config) {
+    size_t count = 1;
+    unsigned bits = 0;
+    while (count < (shard_count ? shard_count : CMAP_DEFAULT_SHARDS)) {
+        count *= 2;
+        bits++;
+    }
+
+    ConcurrentMap* cmap = malloc(sizeof(ConcurrentMap));
+    if (!cmap) return NULL;
+
+    cmap->shards = aligned_alloc(sizeof(CMapShard), count * sizeof(CMapShard));
+    if (!cmap->shards) {
+        free(cmap);
+        return NULL;
+    }
+    map_count_alloc(sizeof(ConcurrentMap) + count * sizeof(CMapShard));
+    cmap->shard_count = count;
+    cmap->shard_shift = 64 - bits;
+
+    for (size_t i = 0; i < count; i++) {
+        CMapShard* shard = &cmap->shards[i];
+        shard->map = map_create(initial_capacity / count, config);
+        if (!shard->map || pthread_rwlock_init(&shard->lock, NULL) != 0) {
+            map_destroy(shard->map);
+            destroy_shards(cmap, i);
+            free(cmap);
+            return NULL;
+        }
+    }
+    return cmap;
+}
+
+bool cmap_put(ConcurrentMap* cmap, void* key, void* value) {
+    if (!cmap) return false;
+
+    uint64_t hash;
+    CMapShard* shard = shard_for(cmap, key, &hash);
+    pthread_rwlock_wrlock(&shard->lock);
+    bool added = map_put_hashed(shard->map, key, value, hash);
+    pthread_rwlock_unlock(&shard->lock);
+    return added;
+}
+
+bool cmap_lookup(ConcurrentMap* cmap, const void* key, void** value_out) {
+    if (!cmap) return false;
+
+    uint64_t hash;
+    CMapShard* shard = shard_for(cmap, key, &hash);
+    pthread_rwlock_rdlock(&shard->lock);
+    MapEntry* entry = map_find_hashed(shard->map, key, hash);
+    if (entry && value_out) {
+        *value_out = entry->value;
+    }
+    pthread_rwlock_unlock(&shard->lock);
+    return entry != NULL;
+}
+
+void* cmap_get(ConcurrentMap* cmap, const void* key) {
+    void* value = NULL;
+    cmap_lookup(cmap, key, &value);
+    return value;
+}
+
+bool cmap_contains(ConcurrentMap* cmap, const void* key) {
+    return cmap_lookup(cmap, key, NULL);
+}
+
+bool cmap_remove(ConcurrentMap* cmap, const void* key) {
+    if (!cmap) return false;
+
+    uint64_t hash;
+    CMapShard* shard = shard_for(cmap, key, &hash);
+    pthread_rwlock_wrlock(&shard->lock);
+    bool removed = map_remove_hashed(shard->map, key, hash);
+    pthread_rwlock_unlock(&shard->lock);
+    return removed;
+}
+
+bool cmap_upsert(ConcurrentMap* cmap, void* key, MapUpsertFunc update, void* context) {
+    if (!cmap) return false;
+
+    uint64_t hash;
+    CMapShard* shard = shard_for(cmap, key, &hash);
+    assert(!shard->map->config.value_copy && !shard->map->config.value_size &&
+           !shard->map->config.value_free);
+
+    pthread_rwlock_wrlock(&shard->lock);
+    bool inserted;
+    MapEntry* entry = map_get_or_insert_hashed(shard->map, key, NULL, &inserted, hash);
+    if (entry) {
+        update(&entry->value, !inserted, context);
+    }
+    pthread_rwlock_unlock(&shard->lock);
+    return entry != NULL;
+}
+
+size_t cmap_size(ConcurrentMap* cmap) {
+    if (!cmap) return 0;
+
+    size_t size = 0;
+    for (size_t i = 0; i < cmap->shard_count; i++) {
+        pthread_rwlock_rdlock(&cmap->shards[i].lock);
+        size += map_size(cmap->shards[i].map);
+        pthread_rwlock_unlock(&cmap->shards[i].lock);
+    }
+    return size;
+}
+
+void cmap_clear(ConcurrentMap* cmap) {
+    if (!cmap) return;
+
+    for (size_t i = 0; i < cmap->shard_count; i++) {
+        pthread_rwlock_wrlock(&cmap->shards[i].lock);
+        map_clear(cmap->shards[i].map);
+        pthread_rwlock_unlock(&cmap->shards[i].lock);
+    }
+}
+
+void cmap_destroy(ConcurrentMap* cmap) {
+    if (!cmap) return;
+
+    destroy_shards(cmap, cmap->shard_count);
+    free(cmap);
+}
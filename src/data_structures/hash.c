@@ -0,0 +1,19 @@
+#include "data_structures/hash.h"
+#include <time.h>
+#include <unistd.h>
+#include <sys/random.h>
+
+uint64_t hash_seed = HASH_P2;
+
+void hash_seed_init(void) {
+    uint64_t seed;
+    if (getrandom(&seed, sizeof(seed), GRND_NONBLOCK) != (ssize_t)sizeof(seed)) {
+        // no entropy yet (early boot) or no getrandom: still differ per run
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        seed = hash_mix((uint64_t)ts.tv_nsec ^ HASH_P1, (uint64_t)ts.tv_sec ^ (uint64_t)getpid());
+        seed ^= (uint64_t)(uintptr_t)&seed;
+    }
+    // as wyhash prepares its seed, so weak seeds still spread
+    hash_seed = seed ^ hash_mix(seed ^ HASH_P0, HASH_P1);
+}
@@ -1,223 +1,673 @@
 #include "data_structures/map.h"
+#include "data_structures/hash.h"
 #include <stdlib.h>
 #include <string.h>
 #include <assert.h>
 #include <math.h>
 
-#define DEFAULT_INITIAL_CAPACITY 16
-#define DEFAULT_LOAD_FACTOR 0.75f
-#define MIN_CAPACITY 8
+#define MIN_CAPACITY MAP_GROUP_WIDTH
+
+// old slots an incremental resize moves per put or remove. the old table is
+// empty after capacity / MIGRATE_SLOTS operations, long before the new one can
+// fill: even a same-size rehash starts below 25/32 full and its inserts only
+// bring it to 26/32 of the 7/8 limit.
+#define MIGRATE_SLOTS (2 * MAP_GROUP_WIDTH)
+
+// keys a batch call hashes and prefetches before it probes for the first
+#define BATCH_SIZE 16
+
+// payload arenas start small; most maps with copied keys hold few of them
+#define PAYLOAD_CHUNK_SIZE (4 * 1024)
+
+MapAllocHook map_alloc_hook = NULL;
 
 // ==================== internal helper functions ====================
 
-static size_t get_bucket_index(const Map* map, const void* key) {
-    unsigned long hash = map->config.hash(key);
-    return hash % map->bucket_count;
+static void set_table_ctrl(int8_t* ctrl, size_t capacity, size_t index, int8_t value) {
+    ctrl[index] = value;
+    // keep the copy of the first group's bytes behind the table in sync
+    if (index < MAP_GROUP_WIDTH - 1) {
+        ctrl[capacity + index] = value;
+    }
 }
 
-static void map_resize(Map* map, size_t new_capacity);
+static void set_ctrl(Map* map, size_t index, int8_t value) {
+    set_table_ctrl(map->ctrl, map->capacity, index, value);
+}
 
-// ==================== core API implementation ====================
+static bool is_small(const Map* map) {
+    return map->entries == NULL;
+}
 
-Map* map_create(size_t initial_capacity, MapConfig config) {
-    if (initial_capacity < MIN_CAPACITY) {
-        initial_capacity = MIN_CAPACITY;
+// smallest capacity that holds count entries without growing
+static size_t capacity_for(size_t count) {
+    size_t capacity = MIN_CAPACITY;
+    while (map_max_load(capacity) < count) {
+        capacity *= 2;
+    }
+    return capacity;
+}
+
+// entries and control bytes share one allocation
+static bool allocate_table(Map* map, size_t capacity) {
+    size_t entry_bytes = capacity * sizeof(MapEntry);
+    size_t ctrl_bytes = capacity + MAP_GROUP_WIDTH - 1;
+    MapEntry* entries = malloc(entry_bytes + ctrl_bytes);
+    if (!entries) return false;
+    map_count_alloc(entry_bytes + ctrl_bytes);
+
+    map->entries = entries;
+    map->ctrl = (int8_t*)(entries + capacity);
+    map->capacity = capacity;
+    map->growth_left = map_max_load(capacity);
+    memset(map->ctrl, MAP_CTRL_EMPTY, ctrl_bytes);
+    return true;
+}
+
+// triangular probing over groups; with a power-of-two capacity every slot
+// is covered before the sequence repeats
+// returns: slot index of key, or capacity when absent
+static size_t probe_table(const Map* map, const MapEntry* entries, const int8_t* ctrl,
+                          size_t capacity, const void* key, uint64_t hash) {
+    size_t mask = capacity - 1;
+    size_t position = map_hash_position(hash) & mask;
+    int8_t tag = map_hash_tag(hash);
+
+    for (size_t stride = 0; stride <= capacity; ) {
+        const int8_t* group = ctrl + position;
+        for (MapGroupMask match = map_group_match(group, tag); match; match &= match - 1) {
+            size_t index = (position + (size_t)__builtin_ctz(match)) & mask;
+            // the full hash weeds out the 1 in 128 tag collisions first
+            if (entries[index].hash == hash && map->config.key_equal(entries[index].key, key)) {
+                return index;
+            }
+        }
+        // an empty slot ends every probe sequence that could hold the key
+        if (map_group_match_empty(group)) break;
+
+        stride += MAP_GROUP_WIDTH;
+        position = (position + stride) & mask;
+    }
+    return capacity;
+}
+
+static size_t find_slot(const Map* map, const void* key, uint64_t hash) {
+    return probe_table(map, map->entries, map->ctrl, map->capacity, key, hash);
+}
+
+// returns: slot index of key in the table being drained, or old_capacity
+static size_t find_old_slot(const Map* map, const void* key, uint64_t hash) {
+    if (!map->old_entries) return map->old_capacity;
+    return probe_table(map, map->old_entries, map->old_ctrl, map->old_capacity, key, hash);
+}
+
+static uint64_t hash_key(const Map* map, const void* key) {
+    return map_mix_hash(map->config.hash(key));
+}
+
+// the stored hash decides almost every mismatch without calling key_equal
+static MapEntry* find_small(const Map* map, const void* key, uint64_t hash) {
+    for (size_t i = 0; i < map->size; i++) {
+        const MapEntry* entry = &map->small[i];
+        if (entry->hash == hash && map->config.key_equal(entry->key, key)) {
+            return (MapEntry*)entry;
+        }
+    }
+    return NULL;
+}
+
+// the entry of key in either table (or inline), or NULL
+static MapEntry* find_entry(const Map* map, const void* key, uint64_t hash) {
+    if (is_small(map)) return find_small(map, key, hash);
+
+    size_t index = find_slot(map, key, hash);
+    if (index < map->capacity) return &map->entries[index];
+
+    index = find_old_slot(map, key, hash);
+    return index < map->old_capacity ? &map->old_entries[index] : NULL;
+}
+
+// first empty or deleted slot on the key's probe sequence
+static size_t find_free_slot(const Map* map, uint64_t hash) {
+    size_t mask = map->capacity - 1;
+    size_t position = map_hash_position(hash) & mask;
+
+    for (size_t stride = 0; ; ) {
+        MapGroupMask free_slots = map_group_match_free(map->ctrl + position);
+        if (free_slots) {
+            return (position + (size_t)__builtin_ctz(free_slots)) & mask;
+        }
+        stride += MAP_GROUP_WIDTH;
+        position = (position + stride) & mask;
+    }
+}
+
+// move up to slots old slots into the current table; the old table is freed
+// once it is empty
+static void migrate(Map* map, size_t slots) {
+    size_t end = map->old_capacity - map->migrated > slots ? map->migrated + slots
+                                                          : map->old_capacity;
+
+    for (; map->migrated < end; map->migrated++) {
+        size_t i = map->migrated;
+        if (map->old_ctrl[i] < 0) continue;
+
+        uint64_t hash = map->old_entries[i].hash;
+        size_t index = find_free_slot(map, hash);
+        if (map->ctrl[index] == MAP_CTRL_EMPTY) {
+            map->growth_left--;
+        }
+        set_ctrl(map, index, map_hash_tag(hash));
+        map->entries[index] = map->old_entries[i];
+
+        // moved entries must no longer be found in the old table
+        set_table_ctrl(map->old_ctrl, map->old_capacity, i, MAP_CTRL_DELETED);
+    }
+
+    if (map->migrated == map->old_capacity) {
+        free(map->old_entries);
+        map->old_entries = NULL;
+        map->old_ctrl = NULL;
+        map->old_capacity = 0;
+        map->migrated = 0;
+    }
+}
+
+static void finish_migration(Map* map) {
+    if (map->old_entries) {
+        migrate(map, map->old_capacity);
+    }
+}
+
+// switch to a fresh table; the entries stay in the old one until migrated.
+// also how tombstones are cleared
+static bool start_rehash(Map* map, size_t new_capacity) {
+    finish_migration(map);
+
+    MapEntry* old_entries = map->entries;
+    int8_t* old_ctrl = map->ctrl;
+    size_t old_capacity = map->capacity;
+
+    if (!allocate_table(map, new_capacity)) {
+        return false;
+    }
+
+    map->old_entries = old_entries;
+    map->old_ctrl = old_ctrl;
+    map->old_capacity = old_capacity;
+    map->migrated = 0;
+    return true;
+}
+
+static bool rehash(Map* map, size_t new_capacity) {
+    if (!start_rehash(map, new_capacity)) return false;
+    finish_migration(map);
+    return true;
+}
+
+// move the inline entries into a table of the given capacity
+static bool promote(Map* map, size_t capacity) {
+    if (!allocate_table(map, capacity)) return false;
+
+    for (size_t i = 0; i < map->size; i++) {
+        uint64_t hash = map->small[i].hash;
+        size_t index = find_free_slot(map, hash);
+        set_ctrl(map, index, map_hash_tag(hash));
+        map->entries[index] = map->small[i];
+    }
+    map->growth_left -= map->size;
+    return true;
+}
+
+// make sure one more entry can go into an empty slot
+static bool reserve_one(Map* map) {
+    if (map->growth_left > 0) return true;
+
+    // only reachable with a resize still running if MIGRATE_SLOTS is too small
+    finish_migration(map);
+    if (map->growth_left > 0) return true;
+
+    // largely tombstones: the same capacity is enough once they are dropped
+    size_t capacity = map->size * 32 <= map->capacity * 25 ? map->capacity : map->capacity * 2;
+    return map->config.incremental ? start_rehash(map, capacity) : rehash(map, capacity);
+}
+
+static void* copy_payload(Map* map, const void* payload, size_t size) {
+    if (!map->payloads && !(map->payloads = arena_create(PAYLOAD_CHUNK_SIZE))) {
+        return NULL;
+    }
+
+    void* copy = arena_alloc(map->payloads, size);
+    if (!copy) return NULL;
+    map_count_alloc(size);
+    memcpy(copy, payload, size);
+    return copy;
+}
+
+// the key as the map keeps it: an arena copy, a callback copy, or as given
+static void* store_key(Map* map, void* key) {
+    if (map->config.key_size) {
+        return copy_payload(map, key, map->config.key_size(key));
+    }
+    return map->config.key_copy ? map->config.key_copy(key) : key;
+}
+
+static void* store_value(Map* map, void* value) {
+    if (map->config.value_size) {
+        return copy_payload(map, value, map->config.value_size(value));
+    }
+    return map->config.value_copy ? map->config.value_copy(value) : value;
+}
+
+static void replace_value(Map* map, MapEntry* entry, void* value) {
+    // an arena payload is overwritten in place when the new one fits
+    if (map->config.value_size) {
+        size_t size = map->config.value_size(value);
+        if (size <= map->config.value_size(entry->value)) {
+            memmove(entry->value, value, size);
+        } else {
+            void* copy = copy_payload(map, value, size);
+            if (copy) entry->value = copy;
+        }
+        return;
+    }
+
+    void* new_value = store_value(map, value);
+    if (map->config.value_free && entry->value != new_value) {
+        map->config.value_free(entry->value);
+    }
+    entry->value = new_value;
+}
+
+// add a key known to be absent
+// returns: its entry, or NULL if the table could not grow or a copy failed
+static MapEntry* insert_new(Map* map, void* key, void* value, uint64_t hash) {
+    if (is_small(map) && map->size < MAP_SMALL_CAPACITY) {
+        void* stored_key = store_key(map, key);
+        void* stored_value = store_value(map, value);
+        if ((map->config.key_size && !stored_key) || (map->config.value_size && !stored_value)) {
+            return NULL;
+        }
+
+        MapEntry* entry = &map->small[map->size++];
+        entry->key = stored_key;
+        entry->value = stored_value;
+        entry->hash = hash;
+        return entry;
+    }
+    if (is_small(map) && !promote(map, capacity_for(MAP_SMALL_CAPACITY + 1))) {
+        return NULL;
     }
 
+    size_t index = find_free_slot(map, hash);
+    if (map->ctrl[index] == MAP_CTRL_EMPTY) {
+        if (!reserve_one(map)) return NULL;
+        // a rehash moved everything
+        index = find_free_slot(map, hash);
+    }
+
+    void* stored_key = store_key(map, key);
+    void* stored_value = store_value(map, value);
+    if ((map->config.key_size && !stored_key) || (map->config.value_size && !stored_value)) {
+        return NULL;
+    }
+
+    // reusing a tombstone costs no growth
+    if (map->ctrl[index] == MAP_CTRL_EMPTY) {
+        map->growth_left--;
+    }
+    set_ctrl(map, index, map_hash_tag(hash));
+
+    MapEntry* entry = &map->entries[index];
+    entry->key = stored_key;
+    entry->value = stored_value;
+    entry->hash = hash;
+    map->size++;
+    return entry;
+}
+
+// start loading the control bytes of the first group a probe for hash reads
+static void prefetch_group(const Map* map, uint64_t hash) {
+    __builtin_prefetch(map->ctrl + (map_hash_position(hash) & (map->capacity - 1)));
+}
+
+// once the control bytes are in: start loading the entry the first tag
+// match points at, almost always the one the probe ends on
+static void prefetch_entry(const Map* map, uint64_t hash) {
+    size_t mask = map->capacity - 1;
+    size_t position = map_hash_position(hash) & mask;
+    MapGroupMask match = map_group_match(map->ctrl + position, map_hash_tag(hash));
+    if (match) {
+        __builtin_prefetch(&map->entries[(position + (size_t)__builtin_ctz(match)) & mask]);
+    }
+}
+
+// hash one block of keys and prefetch what each probe will read first
+// returns: number of keys in the block
+static size_t prepare_block(const Map* map, const void* const* keys, size_t count,
+                            uint64_t* hashes) {
+    size_t block = count < BATCH_SIZE ? count : BATCH_SIZE;
+    if (is_small(map)) {
+        // the inline entries are already in the header's cache lines
+        for (size_t i = 0; i < block; i++) {
+            hashes[i] = hash_key(map, keys[i]);
+        }
+        return block;
+    }
+    for (size_t i = 0; i < block; i++) {
+        hashes[i] = hash_key(map, keys[i]);
+        prefetch_group(map, hashes[i]);
+    }
+    for (size_t i = 0; i < block; i++) {
+        prefetch_entry(map, hashes[i]);
+    }
+    return block;
+}
+
+// arena payloads are released with the arena, never one by one
+static void release_entry(Map* map, MapEntry* entry) {
+    if (map->config.key_free && !map->config.key_size) {
+        map->config.key_free(entry->key);
+    }
+    if (map->config.value_free && !map->config.value_size) {
+        map->config.value_free(entry->value);
+    }
+}
+
+// ==================== core API implementation ====================
+
+Map* map_create(size_t initial_capacity, MapConfig config) {
     // must have hash and equality functions
     assert(config.hash != NULL);
     assert(config.key_equal != NULL);
 
     Map* map = malloc(sizeof(Map));
     if (!map) return NULL;
+    map_count_alloc(sizeof(Map));
 
-    map->buckets = calloc(initial_capacity, sizeof(MapEntry*));
-    if (!map->buckets) {
+    map->size = 0;
+    map->config = config;
+    map->payloads = NULL;
+    map->old_entries = NULL;
+    map->old_ctrl = NULL;
+    map->old_capacity = 0;
+    map->migrated = 0;
+
+    // small maps allocate their table only if they outgrow the header
+    map->entries = NULL;
+    map->ctrl = NULL;
+    map->capacity = 0;
+    map->growth_left = 0;
+    if (initial_capacity > MAP_SMALL_CAPACITY && !allocate_table(map, capacity_for(initial_capacity))) {
         free(map);
         return NULL;
     }
 
-    map->bucket_count = initial_capacity;
-    map->size = 0;
-    map->load_factor = DEFAULT_LOAD_FACTOR;
-    map->config = config;
-
     return map;
 }
 
-bool map_put(Map* map, void* key, void* value) {
+bool map_put_hashed(Map* map, void* key, void* value, uint64_t hash) {
     if (!map) return false;
 
-    // check if resize needed
-    if ((float)map->size / map->bucket_count > map->load_factor) {
-        map_resize(map, map->bucket_count * 2);
+    if (map->old_entries) {
+        migrate(map, MIGRATE_SLOTS);
     }
 
-    size_t bucket_idx = get_bucket_index(map, key);
-    MapEntry* entry = map->buckets[bucket_idx];
-
     // check if key exists (update case)
-    while (entry) {
-        if (map->config.key_equal(entry->key, key)) {
-            // update existing entry
-            void* new_value = map->config.value_copy
-                ? map->config.value_copy(value)
-                : value;
-
-            if (map->config.value_free && entry->value != new_value) {
-                map->config.value_free(entry->value);
-            }
-            entry->value = new_value;
-            return false;  // Updated existing
-        }
-        entry = entry->next;
+    MapEntry* entry = find_entry(map, key, hash);
+    if (entry) {
+        replace_value(map, entry, value);
+        return false;  // Updated existing
     }
 
-    // create new entry
-    MapEntry* new_entry = malloc(sizeof(MapEntry));
-    if (!new_entry) return false;
-
-    new_entry->key = map->config.key_copy
-        ? map->config.key_copy(key)
-        : key;
-    new_entry->value = map->config.value_copy
-        ? map->config.value_copy(value)
-        : value;
-    new_entry->next = map->buckets[bucket_idx];
-    map->buckets[bucket_idx] = new_entry;
-    map->size++;
+    return insert_new(map, key, value, hash) != NULL;  // New entry
+}
 
-    return true;  // New entry
+bool map_put(Map* map, void* key, void* value) {
+    if (!map) return false;
+    return map_put_hashed(map, key, value, hash_key(map, key));
 }
 
 void* map_get(const Map* map, const void* key) {
     if (!map) return NULL;
 
-    size_t bucket_idx = get_bucket_index(map, key);
-    MapEntry* entry = map->buckets[bucket_idx];
-
-    while (entry) {
-        if (map->config.key_equal(entry->key, key)) {
-            return entry->value;
-        }
-        entry = entry->next;
-    }
-
-    return NULL;
+    const MapEntry* entry = find_entry(map, key, hash_key(map, key));
+    return entry ? entry->value : NULL;
 }
 
 bool map_contains(const Map* map, const void* key) {
-    return map_get(map, key) != NULL;
+    if (!map) return false;
+
+    // a stored NULL (or integer 0) value still counts
+    return find_entry(map, key, hash_key(map, key)) != NULL;
 }
 
 bool map_remove(Map* map, const void* key) {
     if (!map) return false;
+    return map_remove_hashed(map, key, hash_key(map, key));
+}
 
-    size_t bucket_idx = get_bucket_index(map, key);
-    MapEntry* entry = map->buckets[bucket_idx];
-    MapEntry* prev = NULL;
-
-    while (entry) {
-        if (map->config.key_equal(entry->key, key)) {
-            // found it, remove it
-            if (prev) {
-                prev->next = entry->next;
-            } else {
-                map->buckets[bucket_idx] = entry->next;
-            }
+bool map_remove_hashed(Map* map, const void* key, uint64_t hash) {
+    if (!map) return false;
 
-            // free key and value if free functions provided
-            if (map->config.key_free) {
-                map->config.key_free(entry->key);
-            }
-            if (map->config.value_free) {
-                map->config.value_free(entry->value);
-            }
+    if (is_small(map)) {
+        MapEntry* entry = find_small(map, key, hash);
+        if (!entry) return false;
+
+        // the last entry fills the gap
+        release_entry(map, entry);
+        *entry = map->small[--map->size];
+        return true;
+    }
 
-            free(entry);
-            map->size--;
-            return true;
+    if (map->old_entries) {
+        migrate(map, MIGRATE_SLOTS);
+    }
+
+    size_t index = find_slot(map, key, hash);
+    if (index < map->capacity) {
+        release_entry(map, &map->entries[index]);
+        map->size--;
+
+        if (map_slot_never_full(map->ctrl, index, map->capacity - 1)) {
+            set_ctrl(map, index, MAP_CTRL_EMPTY);
+            map->growth_left++;
+        } else {
+            set_ctrl(map, index, MAP_CTRL_DELETED);
         }
-        prev = entry;
-        entry = entry->next;
+        return true;
     }
 
-    return false;
+    // the old table is thrown away whole, so a tombstone is all it needs
+    index = find_old_slot(map, key, hash);
+    if (index == map->old_capacity) return false;
+
+    release_entry(map, &map->old_entries[index]);
+    map->size--;
+    set_table_ctrl(map->old_ctrl, map->old_capacity, index, MAP_CTRL_DELETED);
+    return true;
 }
 
-size_t map_size(const Map* map) {
-    return map ? map->size : 0;
+// ==================== entry API implementation ====================
+
+MapEntry* map_find(const Map* map, const void* key) {
+    if (!map) return NULL;
+    return find_entry(map, key, hash_key(map, key));
 }
 
-bool map_is_empty(const Map* map) {
-    return map_size(map) == 0;
+MapEntry* map_get_or_insert(Map* map, void* key, void* value, bool* inserted) {
+    if (!map) {
+        if (inserted) *inserted = false;
+        return NULL;
+    }
+    return map_get_or_insert_hashed(map, key, value, inserted, hash_key(map, key));
 }
 
-void map_clear(Map* map) {
-    if (!map) return;
+MapEntry* map_get_or_insert_hashed(Map* map, void* key, void* value, bool* inserted,
+                                   uint64_t hash) {
+    if (inserted) *inserted = false;
+    if (!map) return NULL;
 
-    for (size_t i = 0; i < map->bucket_count; i++) {
-        MapEntry* entry = map->buckets[i];
-        while (entry) {
-            MapEntry* next = entry->next;
+    if (map->old_entries) {
+        migrate(map, MIGRATE_SLOTS);
+    }
 
-            if (map->config.key_free) {
-                map->config.key_free(entry->key);
-            }
-            if (map->config.value_free) {
-                map->config.value_free(entry->value);
-            }
+    MapEntry* entry = find_entry(map, key, hash);
+    if (entry) return entry;
+
+    entry = insert_new(map, key, value, hash);
+    if (entry && inserted) *inserted = true;
+    return entry;
+}
+
+bool map_upsert(Map* map, void* key, MapUpsertFunc update, void* context) {
+    // the callback owns the value slot, so the map must not copy or free it
+    assert(!map || (!map->config.value_copy && !map->config.value_size && !map->config.value_free));
 
-            free(entry);
-            entry = next;
+    bool inserted;
+    MapEntry* entry = map_get_or_insert(map, key, NULL, &inserted);
+    if (!entry) return false;
+
+    update(&entry->value, !inserted, context);
+    return true;
+}
+
+// ==================== prehashed API implementation ====================
+
+uint64_t map_hash_key(const Map* map, const void* key) {
+    return hash_key(map, key);
+}
+
+MapEntry* map_find_hashed(const Map* map, const void* key, uint64_t hash) {
+    if (!map) return NULL;
+    return find_entry(map, key, hash);
+}
+
+// ==================== batch API implementation ====================
+
+size_t map_find_many(const Map* map, const void* const* keys, size_t count,
+                     MapEntry** entries_out) {
+    size_t found = 0;
+    uint64_t hashes[BATCH_SIZE];
+
+    for (size_t start = 0; start < count; ) {
+        if (!map) {
+            entries_out[start++] = NULL;
+            continue;
         }
-        map->buckets[i] = NULL;
-    }
 
-    map->size = 0;
+        // every miss of the block is in flight before the first probe waits
+        size_t block = prepare_block(map, keys + start, count - start, hashes);
+        for (size_t i = 0; i < block; i++) {
+            MapEntry* entry = find_entry(map, keys[start + i], hashes[i]);
+            entries_out[start + i] = entry;
+            found += entry != NULL;
+        }
+        start += block;
+    }
+    return found;
 }
 
-void map_destroy(Map* map) {
-    if (!map) return;
+size_t map_get_many(const Map* map, const void* const* keys, size_t count, void** values_out) {
+    size_t found = 0;
+    MapEntry* entries[BATCH_SIZE];
 
-    map_clear(map);
-    free(map->buckets);
-    free(map);
+    for (size_t start = 0; start < count; start += BATCH_SIZE) {
+        size_t block = count - start < BATCH_SIZE ? count - start : BATCH_SIZE;
+        found += map_find_many(map, keys + start, block, entries);
+        for (size_t i = 0; i < block; i++) {
+            values_out[start + i] = entries[i] ? entries[i]->value : NULL;
+        }
+    }
+    return found;
 }
 
-static void map_resize(Map* map, size_t new_capacity) {
-    if (!map || new_capacity < MIN_CAPACITY) return;
+size_t map_put_many(Map* map, void* const* keys, void* const* values, size_t count) {
+    if (!map) return 0;
 
-    MapEntry** old_buckets = map->buckets;
-    size_t old_capacity = map->bucket_count;
+    size_t added = 0;
+    uint64_t hashes[BATCH_SIZE];
 
-    // allocate new buckets
-    map->buckets = calloc(new_capacity, sizeof(MapEntry*));
-    if (!map->buckets) {
-        map->buckets = old_buckets;  // Restore on failure
-        return;
+    for (size_t start = 0; start < count; ) {
+        // a resize inside the block only makes the later prefetches useless
+        size_t block = prepare_block(map, (const void* const*)keys + start, count - start, hashes);
+        for (size_t i = 0; i < block; i++) {
+            added += map_put_hashed(map, keys[start + i], values[start + i], hashes[i]);
+        }
+        start += block;
     }
+    return added;
+}
 
-    map->bucket_count = new_capacity;
-    map->size = 0;
+bool map_reserve(Map* map, size_t count) {
+    if (!map) return false;
+
+    if (is_small(map)) {
+        return count <= MAP_SMALL_CAPACITY || promote(map, capacity_for(count));
+    }
 
-    // rehash all entries
-    for (size_t i = 0; i < old_capacity; i++) {
-        MapEntry* entry = old_buckets[i];
-        while (entry) {
-            MapEntry* next = entry->next;
+    finish_migration(map);
+    if (count <= map->size + map->growth_left) return true;
 
-            // reinsert into new buckets
-            size_t new_idx = get_bucket_index(map, entry->key);
-            entry->next = map->buckets[new_idx];
-            map->buckets[new_idx] = entry;
-            map->size++;
+    // never shrinks; at the same capacity this drops the tombstones
+    size_t capacity = capacity_for(count);
+    return rehash(map, capacity > map->capacity ? capacity : map->capacity);
+}
 
-            entry = next;
+size_t map_size(const Map* map) {
+    return map ? map->size : 0;
+}
+
+bool map_is_empty(const Map* map) {
+    return map_size(map) == 0;
+}
+
+void map_clear(Map* map) {
+    if (!map) return;
+
+    bool frees_keys = map->config.key_free && !map->config.key_size;
+    bool frees_values = map->config.value_free && !map->config.value_size;
+    if (is_small(map)) {
+        for (size_t i = 0; (frees_keys || frees_values) && i < map->size; i++) {
+            release_entry(map, &map->small[i]);
+        }
+        map->size = 0;
+        arena_rewind(map->payloads);
+        return;
+    }
+
+    for (size_t i = 0; (frees_keys || frees_values) && i < map->capacity; i++) {
+        if (map->ctrl[i] >= 0) {
+            release_entry(map, &map->entries[i]);
         }
     }
+    for (size_t i = 0; (frees_keys || frees_values) && i < map->old_capacity; i++) {
+        if (map->old_ctrl[i] >= 0) {
+            release_entry(map, &map->old_entries[i]);
+        }
+    }
+
+    free(map->old_entries);
+    map->old_entries = NULL;
+    map->old_ctrl = NULL;
+    map->old_capacity = 0;
+    map->migrated = 0;
 
-    free(old_buckets);
+    memset(map->ctrl, MAP_CTRL_EMPTY, map->capacity + MAP_GROUP_WIDTH - 1);
+    map->size = 0;
+    map->growth_left = map_max_load(map->capacity);
+
+    // every copied key and value at once
+    arena_rewind(map->payloads);
+}
+
+void map_destroy(Map* map) {
+    if (!map) return;
+
+    map_clear(map);
+    arena_destroy(map->payloads);
+    free(map->entries);
+    free(map);
 }
 
 // ==================== iteration API implementation ====================
@@ -225,64 +675,51 @@ static void map_resize(Map* map, size_t new_capacity) {
 MapIterator map_iterator(const Map* map) {
     MapIterator iter = {
         .map = map,
-        .bucket_index = 0,
-        .current_entry = NULL
+        .index = 0
     };
-
-    if (map && map->bucket_count > 0) {
-        // find first non-empty bucket
-        for (size_t i = 0; i < map->bucket_count; i++) {
-            if (map->buckets[i]) {
-                iter.bucket_index = i;
-                iter.current_entry = map->buckets[i];
-                break;
-            }
-        }
-    }
-
     return iter;
 }
 
-bool map_iterator_has_next(MapIterator* iter) {
-    return iter && iter->current_entry != NULL;
+// the control byte of an iterator position: old table slots come first
+static int8_t iterator_ctrl(const Map* map, size_t index) {
+    return index < map->old_capacity ? map->old_ctrl[index]
+                                     : map->ctrl[index - map->old_capacity];
 }
 
-bool map_iterator_next(MapIterator* iter, void** key_out, void** value_out) {
-    if (!iter || !iter->current_entry) return false;
+bool map_iterator_has_next(MapIterator* iter) {
+    if (!iter || !iter->map) return false;
+    if (is_small(iter->map)) return iter->index < iter->map->size;
 
-    // return current entry
-    if (key_out) *key_out = iter->current_entry->key;
-    if (value_out) *value_out = iter->current_entry->value;
+    // skip ahead to the next full slot
+    size_t end = iter->map->old_capacity + iter->map->capacity;
+    while (iter->index < end && iterator_ctrl(iter->map, iter->index) < 0) {
+        iter->index++;
+    }
+    return iter->index < end;
+}
 
-    // advance to next entry
-    if (iter->current_entry->next) {
-        iter->current_entry = iter->current_entry->next;
+bool map_iterator_next(MapIterator* iter, void** key_out, void** value_out) {
+    if (!map_iterator_has_next(iter)) return false;
+
+    const Map* map = iter->map;
+    size_t index = iter->index++;
+    const MapEntry* entry;
+    if (is_small(map)) {
+        entry = &map->small[index];
+    } else if (index < map->old_capacity) {
+        entry = &map->old_entries[index];
     } else {
-        // find next non-empty bucket
-        iter->current_entry = NULL;
-        for (size_t i = iter->bucket_index + 1; i < iter->map->bucket_count; i++) {
-            if (iter->map->buckets[i]) {
-                iter->bucket_index = i;
-                iter->current_entry = iter->map->buckets[i];
-                break;
-            }
-        }
+        entry = &map->entries[index - map->old_capacity];
     }
-
+    if (key_out) *key_out = entry->key;
+    if (value_out) *value_out = entry->value;
     return true;
 }
 
 // ==================== built-in hash functions ====================
 
 unsigned long hash_int(const void* key) {
-    unsigned long k = (unsigned long)(intptr_t)key;
-    // wang's integer hash
-    k = (k ^ 61) ^ (k >> 16);
-    k = k + (k << 3);
-    k = k ^ (k >> 4);
-    k = k * 0x27d4eb2d;
-    k = k ^ (k >> 15);
-    return k;
+    return hash_u64((uint64_t)(intptr_t)key);
 }
 
 unsigned long hash_float(const void* key) {
@@ -290,24 +727,16 @@ unsigned long hash_float(const void* key) {
     // hash the bit pattern of the float
     unsigned int bits;
     memcpy(&bits, &f, sizeof(float));
-    return hash_int((void*)(intptr_t)bits);
+    return hash_u64(bits);
 }
 
 unsigned long hash_char(const void* key) {
     char c = (char)(intptr_t)key;
-    return hash_int((void*)(intptr_t)c);
+    return hash_u64((unsigned char)c);
 }
 
 unsigned long hash_string(const void* key) {
-    const char* str = (const char*)key;
-    unsigned long hash = 2166136261u;  // FNV-1a offset basis
-
-    while (*str) {
-        hash ^= (unsigned char)(*str++);
-        hash *= 16777619;  // FNV-1a prime
-    }
-
-    return hash;
+    return hash_cstring((const char*)key);
 }
 
 unsigned long hash_pointer(const void* key) {
@@ -343,14 +772,27 @@ bool key_equal_pointer(const void* k1, const void* k2) {
 
 void* key_copy_string(const void* key) {
     if (!key) return NULL;
+    map_count_alloc(strlen((const char*)key) + 1);
     return strdup((const char*)key);
 }
 
 void* value_copy_string(const void* value) {
     if (!value) return NULL;
+    map_count_alloc(strlen((const char*)value) + 1);
     return strdup((const char*)value);
 }
 
+// ==================== built-in payload sizes ====================
+
+size_t payload_size_string(const void* payload) {
+    return strlen((const char*)payload) + 1;
+}
+
+size_t payload_size_float(const void* payload) {
+    (void)payload;
+    return sizeof(float);
+}
+
 // ==================== built-in free functions ====================
 
 void key_free_string(void* key) {
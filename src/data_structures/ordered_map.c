@@ -0,0 +1,341 @@
+#include "data_structures/ordered_map.h"
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#define MIN_CAPACITY MAP_GROUP_WIDTH
+#define MIN_ENTRIES 8
+
+// payload arenas start small; most maps with copied keys hold few of them
+#define PAYLOAD_CHUNK_SIZE (4 * 1024)
+
+// ==================== internal helper functions ====================
+
+static void set_ctrl(OrderedMap* map, size_t index, int8_t value) {
+    map->ctrl[index] = value;
+    // keep the copy of the first group's bytes behind the index in sync
+    if (index < MAP_GROUP_WIDTH - 1) {
+        map->ctrl[map->capacity + index] = value;
+    }
+}
+
+static uint64_t hash_key(const OrderedMap* map, const void* key) {
+    return map_mix_hash(map->config.hash(key));
+}
+
+// slot numbers and control bytes share one allocation; replaces the old index
+static bool allocate_index(OrderedMap* map, size_t capacity) {
+    size_t slot_bytes = capacity * sizeof(uint32_t);
+    size_t ctrl_bytes = capacity + MAP_GROUP_WIDTH - 1;
+    uint32_t* slots = malloc(slot_bytes + ctrl_bytes);
+    if (!slots) return false;
+    map_count_alloc(slot_bytes + ctrl_bytes);
+
+    free(map->slots);
+    map->slots = slots;
+    map->ctrl = (int8_t*)(slots + capacity);
+    map->capacity = capacity;
+    map->growth_left = map_max_load(capacity);
+    memset(map->ctrl, MAP_CTRL_EMPTY, ctrl_bytes);
+    return true;
+}
+
+// the same group probing as Map, looking through the slot to the entry
+// returns: slot index of key, or capacity when absent
+static size_t find_slot(const OrderedMap* map, const void* key, uint64_t hash) {
+    size_t mask = map->capacity - 1;
+    size_t position = map_hash_position(hash) & mask;
+    int8_t tag = map_hash_tag(hash);
+
+    for (size_t stride = 0; stride <= map->capacity; ) {
+        const int8_t* group = map->ctrl + position;
+        for (MapGroupMask match = map_group_match(group, tag); match; match &= match - 1) {
+            size_t index = (position + (size_t)__builtin_ctz(match)) & mask;
+            const OrderedEntry* entry = &map->entries[map->slots[index]];
+            if (entry->hash == hash && map->config.key_equal(entry->key, key)) {
+                return index;
+            }
+        }
+        if (map_group_match_empty(group)) break;
+
+        stride += MAP_GROUP_WIDTH;
+        position = (position + stride) & mask;
+    }
+    return map->capacity;
+}
+
+static size_t find_free_slot(const OrderedMap* map, uint64_t hash) {
+    size_t mask = map->capacity - 1;
+    size_t position = map_hash_position(hash) & mask;
+
+    for (size_t stride = 0; ; ) {
+        MapGroupMask free_slots = map_group_match_free(map->ctrl + position);
+        if (free_slots) {
+            return (position + (size_t)__builtin_ctz(free_slots)) & mask;
+        }
+        stride += MAP_GROUP_WIDTH;
+        position = (position + stride) & mask;
+    }
+}
+
+// close the holes of the dense array and index what is left from the stored
+// hashes; also how tombstones are cleared
+static bool rebuild(OrderedMap* map, size_t capacity) {
+    if (!allocate_index(map, capacity)) return false;
+
+    size_t live = 0;
+    for (size_t i = 0; i < map->count; i++) {
+        if (!map->entries[i].live) continue;
+
+        map->entries[live] = map->entries[i];
+        uint64_t hash = map->entries[live].hash;
+        size_t index = find_free_slot(map, hash);
+        set_ctrl(map, index, map_hash_tag(hash));
+        map->slots[index] = (uint32_t)live;
+        live++;
+    }
+    map->count = live;
+    map->growth_left -= live;
+    return true;
+}
+
+// make sure one more entry fits in both the dense array and the index
+static bool reserve_one(OrderedMap* map, uint64_t hash) {
+    if (map->count == map->entries_capacity) {
+        // mostly holes: compacting makes the room
+        if ((map->count - map->size) * 2 > map->count) {
+            if (!rebuild(map, map->capacity)) return false;
+        } else {
+            size_t capacity = map->entries_capacity * 2;
+            OrderedEntry* entries = realloc(map->entries, capacity * sizeof(OrderedEntry));
+            if (!entries) return false;
+            map_count_alloc(capacity * sizeof(OrderedEntry));
+            map->entries = entries;
+            map->entries_capacity = capacity;
+        }
+    }
+
+    if (map->growth_left > 0 || map->ctrl[find_free_slot(map, hash)] == MAP_CTRL_DELETED) {
+        return true;
+    }
+    size_t capacity = map->size * 32 <= map->capacity * 25 ? map->capacity : map->capacity * 2;
+    return rebuild(map, capacity);
+}
+
+static void* copy_payload(OrderedMap* map, const void* payload, size_t size) {
+    if (!map->payloads && !(map->payloads = arena_create(PAYLOAD_CHUNK_SIZE))) {
+        return NULL;
+    }
+
+    void* copy = arena_alloc(map->payloads, size);
+    if (!copy) return NULL;
+    map_count_alloc(size);
+    memcpy(copy, payload, size);
+    return copy;
+}
+
+static void* store_key(OrderedMap* map, void* key) {
+    if (map->config.key_size) {
+        return copy_payload(map, key, map->config.key_size(key));
+    }
+    return map->config.key_copy ? map->config.key_copy(key) : key;
+}
+
+static void* store_value(OrderedMap* map, void* value) {
+    if (map->config.value_size) {
+        return copy_payload(map, value, map->config.value_size(value));
+    }
+    return map->config.value_copy ? map->config.value_copy(value) : value;
+}
+
+// arena payloads are released with the arena, never one by one
+static void release_entry(OrderedMap* map, OrderedEntry* entry) {
+    if (map->config.key_free && !map->config.key_size) {
+        map->config.key_free(entry->key);
+    }
+    if (map->config.value_free && !map->config.value_size) {
+        map->config.value_free(entry->value);
+    }
+}
+
+// ==================== core API implementation ====================
+
+OrderedMap* omap_create(size_t initial_capacity, MapConfig config) {
+    assert(config.hash != NULL);
+    assert(config.key_equal != NULL);
+
+    size_t capacity = MIN_CAPACITY;
+    while (map_max_load(capacity) < initial_capacity) {
+        capacity *= 2;
+    }
+
+    OrderedMap* map = malloc(sizeof(OrderedMap));
+    if (!map) return NULL;
+
+    map->entries_capacity = initial_capacity > MIN_ENTRIES ? initial_capacity : MIN_ENTRIES;
+    map->entries = malloc(map->entries_capacity * sizeof(OrderedEntry));
+    map->slots = NULL;
+    if (!map->entries || !allocate_index(map, capacity)) {
+        free(map->entries);
+        free(map);
+        return NULL;
+    }
+    map_count_alloc(sizeof(OrderedMap) + map->entries_capacity * sizeof(OrderedEntry));
+
+    map->count = 0;
+    map->size = 0;
+    map->config = config;
+    map->payloads = NULL;
+    return map;
+}
+
+bool omap_put(OrderedMap* map, void* key, void* value) {
+    if (!map) return false;
+
+    uint64_t hash = hash_key(map, key);
+    size_t index = find_slot(map, key, hash);
+
+    // update in place: the key keeps its position in the order
+    if (index < map->capacity) {
+        OrderedEntry* entry = &map->entries[map->slots[index]];
+        if (map->config.value_size) {
+            size_t size = map->config.value_size(value);
+            if (size <= map->config.value_size(entry->value)) {
+                memmove(entry->value, value, size);
+            } else {
+                void* copy = copy_payload(map, value, size);
+                if (copy) entry->value = copy;
+            }
+            return false;
+        }
+
+        void* new_value = store_value(map, value);
+        if (map->config.value_free && entry->value != new_value) {
+            map->config.value_free(entry->value);
+        }
+        entry->value = new_value;
+        return false;
+    }
+
+    assert(map->count < UINT32_MAX);
+    if (!reserve_one(map, hash)) return false;
+
+    void* stored_key = store_key(map, key);
+    void* stored_value = store_value(map, value);
+    if ((map->config.key_size && !stored_key) || (map->config.value_size && !stored_value)) {
+        return false;
+    }
+
+    index = find_free_slot(map, hash);
+    if (map->ctrl[index] == MAP_CTRL_EMPTY) {
+        map->growth_left--;
+    }
+    set_ctrl(map, index, map_hash_tag(hash));
+    map->slots[index] = (uint32_t)map->count;
+
+    OrderedEntry* entry = &map->entries[map->count++];
+    entry->key = stored_key;
+    entry->value = stored_value;
+    entry->hash = hash;
+    entry->live = true;
+    map->size++;
+    return true;
+}
+
+void* omap_get(const OrderedMap* map, const void* key) {
+    if (!map) return NULL;
+
+    size_t index = find_slot(map, key, hash_key(map, key));
+    return index < map->capacity ? map->entries[map->slots[index]].value : NULL;
+}
+
+bool omap_contains(const OrderedMap* map, const void* key) {
+    if (!map) return false;
+    return find_slot(map, key, hash_key(map, key)) < map->capacity;
+}
+
+bool omap_remove(OrderedMap* map, const void* key) {
+    if (!map) return false;
+
+    size_t index = find_slot(map, key, hash_key(map, key));
+    if (index == map->capacity) return false;
+
+    OrderedEntry* entry = &map->entries[map->slots[index]];
+    release_entry(map, entry);
+    entry->live = false;
+    map->size--;
+
+    if (map_slot_never_full(map->ctrl, index, map->capacity - 1)) {
+        set_ctrl(map, index, MAP_CTRL_EMPTY);
+        map->growth_left++;
+    } else {
+        set_ctrl(map, index, MAP_CTRL_DELETED);
+    }
+
+    // holes at the end cost nothing to drop; elsewhere they wait for a rebuild
+    while (map->count > 0 && !map->entries[map->count - 1].live) {
+        map->count--;
+    }
+    if (map->count >= MIN_ENTRIES && (map->count - map->size) > map->size) {
+        // compacting at the same capacity cannot fail for want of room;
+        // if the allocation fails the holes simply stay
+        rebuild(map, map->capacity);
+    }
+    return true;
+}
+
+size_t omap_size(const OrderedMap* map) {
+    return map ? map->size : 0;
+}
+
+void omap_clear(OrderedMap* map) {
+    if (!map) return;
+
+    for (size_t i = 0; i < map->count; i++) {
+        if (map->entries[i].live) {
+            release_entry(map, &map->entries[i]);
+        }
+    }
+    memset(map->ctrl, MAP_CTRL_EMPTY, map->capacity + MAP_GROUP_WIDTH - 1);
+    map->count = 0;
+    map->size = 0;
+    map->growth_left = map_max_load(map->capacity);
+
+    // every copied key and value at once
+    arena_rewind(map->payloads);
+}
+
+void omap_destroy(OrderedMap* map) {
+    if (!map) return;
+
+    omap_clear(map);
+    arena_destroy(map->payloads);
+    free(map->entries);
+    free(map->slots);
+    free(map);
+}
+
+// ==================== iteration API implementation ====================
+
+OrderedMapIterator omap_iterator(const OrderedMap* map) {
+    OrderedMapIterator iter = {
+        .map = map,
+        .index = 0
+    };
+    return iter;
+}
+
+bool omap_iterator_next(OrderedMapIterator* iter, void** key_out, void** value_out) {
+    if (!iter || !iter->map) return false;
+
+    // holes are rare: the array is compacted before they outnumber entries
+    while (iter->index < iter->map->count) {
+        const OrderedEntry* entry = &iter->map->entries[iter->index++];
+        if (entry->live) {
+            if (key_out) *key_out = entry->key;
+            if (value_out) *value_out = entry->value;
+            return true;
+        }
+    }
+    return false;
+}
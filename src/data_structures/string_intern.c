@@ -0,0 +1,107 @@
+#include "data_structures/string_intern.h"
+#include "data_structures/hash.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define INITIAL_CAPACITY 256
+#define MAX_LOAD_NUMERATOR 3
+#define MAX_LOAD_DENOMINATOR 4
+
+// ==================== internal helper functions ====================
+
+static bool interner_grow(StringInterner* interner) {
+    size_t new_capacity = interner->capacity * 2;
+    InternSlot* new_slots = calloc(new_capacity, sizeof(InternSlot));
+    if (!new_slots) return false;
+
+    // reinsert using the cached hashes
+    for (size_t i = 0; i < interner->capacity; i++) {
+        InternSlot* slot = &interner->slots[i];
+        if (!slot->str) continue;
+
+        size_t idx = slot->hash & (new_capacity - 1);
+        while (new_slots[idx].str) {
+            idx = (idx + 1) & (new_capacity - 1);
+        }
+        new_slots[idx] = *slot;
+    }
+
+    free(interner->slots);
+    interner->slots = new_slots;
+    interner->capacity = new_capacity;
+    return true;
+}
+
+// ==================== core API implementation ====================
+
+StringInterner* string_interner_create(Arena* arena) {
+    if (!arena) return NULL;
+
+    StringInterner* interner = malloc(sizeof(StringInterner));
+    if (!interner) return NULL;
+
+    interner->slots = calloc(INITIAL_CAPACITY, sizeof(InternSlot));
+    if (!interner->slots) {
+        free(interner);
+        return NULL;
+    }
+
+    interner->capacity = INITIAL_CAPACITY;
+    interner->size = 0;
+    interner->arena = arena;
+    return interner;
+}
+
+const char* string_intern(StringInterner* interner, const char* str) {
+    if (!str) return NULL;
+    return string_intern_len(interner, str, strlen(str));
+}
+
+const char* string_intern_len(StringInterner* interner, const char* str, size_t len) {
+    if (!interner || !str) return NULL;
+
+    unsigned long hash = hash_bytes(str, len);
+    size_t mask = interner->capacity - 1;
+    size_t idx = hash & mask;
+
+    while (interner->slots[idx].str) {
+        InternSlot* slot = &interner->slots[idx];
+        if (slot->hash == hash && slot->length == len &&
+            memcmp(slot->str, str, len) == 0) {
+            return slot->str;
+        }
+        idx = (idx + 1) & mask;
+    }
+
+    const char* copy = arena_strndup(interner->arena, str, len);
+    if (!copy) return NULL;
+
+    interner->slots[idx].str = copy;
+    interner->slots[idx].length = len;
+    interner->slots[idx].hash = hash;
+    interner->size++;
+
+    if (interner->size * MAX_LOAD_DENOMINATOR > interner->capacity * MAX_LOAD_NUMERATOR) {
+        interner_grow(interner);
+    }
+
+    return copy;
+}
+
+size_t string_interner_size(const StringInterner* interner) {
+    return interner ? interner->size : 0;
+}
+
+void string_interner_clear(StringInterner* interner) {
+    if (!interner) return;
+
+    memset(interner->slots, 0, sizeof(InternSlot) * interner->capacity);
+    interner->size = 0;
+}
+
+void string_interner_destroy(StringInterner* interner) {
+    if (!interner) return;
+
+    free(interner->slots);
+    free(interner);
+}
@@ -7,6 +7,8 @@
 #include "types.h"
 #include "ast.h"
 #include "parser.h"
+#include "context.h"
+#include "semantic.h"
 #include "operator_utils.h"
 #include "transpiler/type_registry.h"
 #include "codegen/c_syntax.h"
@@ -16,23 +18,13 @@ const char* get_c_type_string(DataType type) {
     return get_c_type_from_enum(type);
 }
 
-static const char* mangle_identifier(const char* w_name, bool is_function) {
-    // Special case: entry point w() becomes main
-    if (strcmp(w_name, "w") == 0 && is_function) {
-        return "main";
-    }
-
-    // Mangle: W__name_v (variables) or W__name_f (functions)
-    static char buffer[512];
-    snprintf(buffer, sizeof(buffer), "W__%s_%c", w_name, is_function ? 'f' : 'v');
-    return buffer;
-}
-
-static ASTNode* find_entry_point(ASTNode* functions) {
+ASTNode* find_entry_point(ASTNode* functions) {
+    // function names are interned, so the entry point is found by pointer
+    const char* entry_name = ast_intern("w");
     ASTNode* current = functions;
     while (current != NULL) {
         if (current->type == NODE_FUNCTION &&
-            strcmp(current->data.function.name, "w") == 0) {
+            current->data.function.name == entry_name) {
             return current;
         }
         current = current->next;
@@ -40,30 +32,25 @@ static ASTNode* find_entry_point(ASTNode* functions) {
     return NULL;
 }
 
-void generate_log_statement(FILE* output, LogElement* elements, int indent_level) {
+void generate_log_statement(Emitter* output, LogElement* elements, int indent_level) {
     emit_indent(output, indent_level);
-    fprintf(output, C_PRINTF C_LPAREN C_STRING_QUOTE);
+    emit_lit(output, C_PRINTF C_LPAREN C_STRING_QUOTE);
 
     LogElement* current = elements;
     int arg_count = 0;
     while (current != NULL) {
         switch (current->type) {
             case NODE_STRING:
-                fprintf(output, "%s", current->value.string);
+                emit_str(output, current->value.string);
                 break;
             case NODE_NUMBER:
-                fputs(C_FMT_INT, output);
+                emit_lit(output, C_FMT_INT);
                 arg_count++;
                 break;
             case NODE_VARIABLE: {
-                Symbol* symbol = lookup_symbol(getSymbolTable(), current->value.string);
-                if (symbol == NULL) {
-                    parser_error("Undefined variable in log statement");
-                } else {
-                    const char* fmt = get_format_spec_from_enum(symbol->type);
-                    fputs(fmt, output);
-                    arg_count++;
-                }
+                const char* fmt = get_format_spec_from_enum(current->var_type);
+                emit_str(output, fmt);
+                arg_count++;
                 break;
             }
             default:
@@ -72,36 +59,40 @@ void generate_log_statement(FILE* output, LogElement* elements, int indent_level
         current = current->next;
     }
 
-    fprintf(output, C_ESC_NEWLINE C_STRING_QUOTE);
+    emit_lit(output, C_ESC_NEWLINE C_STRING_QUOTE);
 
     current = elements;
     while (current != NULL) {
         if (current->type == NODE_NUMBER) {
-            fprintf(output, C_COMMA "%d", current->value.number);
+            emit_lit(output, C_COMMA);
+            emit_int(output, current->value.number);
         } else if (current->type == NODE_VARIABLE) {
-            fprintf(output, C_COMMA "%s", mangle_identifier(current->value.string, false));
+            emit_lit(output, C_COMMA);
+            emit_identifier(output, current->value.string, false);
         }
         current = current->next;
     }
 
-    fprintf(output, C_RPAREN C_SEMICOLON_NL);
+    emit_lit(output, C_RPAREN C_SEMICOLON_NL);
 }
 
-void generate_expression_with_cast(FILE* output, ASTNode* expr, DataType target_type) {
+void generate_expression_with_cast(Emitter* output, ASTNode* expr, DataType target_type) {
     if (!expr) return;
 
-    DataType expr_type = get_expression_type(expr, getSymbolTable());
+    DataType expr_type = expression_type(expr);
 
     if (expr_type != target_type && compare_types(target_type, expr_type)) {
-        fprintf(output, C_LPAREN "%s" C_RPAREN C_LPAREN, get_c_type_string(target_type));
+        emit_lit(output, C_LPAREN);
+        emit_str(output, get_c_type_string(target_type));
+        emit_lit(output, C_RPAREN C_LPAREN);
         generate(output, expr, 0);
-        fprintf(output, C_RPAREN);
+        emit_lit(output, C_RPAREN);
     } else {
         generate(output, expr, 0);
     }
 }
 
-static void generate_cast_if_needed(FILE* output, DataType from, DataType to) {
+static void generate_cast_if_needed(Emitter* output, DataType from, DataType to) {
     if (from == to) return;
 
     if (can_convert_type(from, to)) {
@@ -109,50 +100,99 @@ static void generate_cast_if_needed(FILE* output, DataType from, DataType to) {
     }
 }
 
-static void generate_binary_expr(FILE* output, ASTNode* node, int indent_level) {
-    if (!node || node->type != NODE_BINARY_EXPR) return;
-
-    DataType left_type = get_expression_type(node->data.binary_expr.left, getSymbolTable());
-    DataType right_type = get_expression_type(node->data.binary_expr.right, getSymbolTable());
-    DataType result_type = get_operation_type(left_type, right_type, char_to_operator(node->data.binary_expr.operator));
-
-    bool needs_parens = node->data.binary_expr.left->type == NODE_BINARY_EXPR ||
-                        node->data.binary_expr.right->type == NODE_BINARY_EXPR;
+// W's binary operators bind like their C counterparts: * and / over + and -
+static int binary_precedence(char op) {
+    return op == '*' || op == '/' ? 2 : 1;
+}
 
-    if (needs_parens && node->data.binary_expr.left->type == NODE_BINARY_EXPR) {
-        fprintf(output, C_LPAREN);
-        generate_cast_if_needed(output, left_type, result_type);
-        generate(output, node->data.binary_expr.left, indent_level);
-        fprintf(output, C_RPAREN);
-    } else {
-        generate_cast_if_needed(output, left_type, result_type);
-        generate(output, node->data.binary_expr.left, indent_level);
+static void generate_binary_operand(Emitter* output, ASTNode* operand, DataType operand_type,
+                                    DataType result_type, bool parens, int indent_level) {
+    // the cast prefixes the operand's first term either way
+    if (parens) {
+        emit_lit(output, C_LPAREN);
+    }
+    generate_cast_if_needed(output, operand_type, result_type);
+    generate(output, operand, indent_level);
+    if (parens) {
+        emit_lit(output, C_RPAREN);
     }
+}
 
-    fprintf(output, "%s", get_binary_operator_string(node->data.binary_expr.operator));
+static void generate_binary_expr(Emitter* output, ASTNode* node, int indent_level) {
+    if (!node || node->type != NODE_BINARY_EXPR) return;
 
-    generate_cast_if_needed(output, right_type, result_type);
-    generate(output, node->data.binary_expr.right, indent_level);
+    ASTNode* left = node->data.binary_expr.left;
+    ASTNode* right = node->data.binary_expr.right;
+
+    // types were cached by the annotation pass; never re-walk subtrees here
+    DataType left_type = expression_type(left);
+    DataType right_type = expression_type(right);
+    DataType result_type = expression_type(node);
+
+    // an operand is wrapped only when C would otherwise regroup it: on the
+    // left when it binds more loosely (a + b) * c, on the right also at equal
+    // precedence, since the operators associate to the left: a - (b - c)
+    int precedence = binary_precedence(node->data.binary_expr.operator);
+    bool left_parens = left->type == NODE_BINARY_EXPR &&
+                       binary_precedence(left->data.binary_expr.operator) < precedence;
+    bool right_parens = right->type == NODE_BINARY_EXPR &&
+                        binary_precedence(right->data.binary_expr.operator) <= precedence;
+
+    generate_binary_operand(output, left, left_type, result_type, left_parens, indent_level);
+    emit_str(output, get_binary_operator_string(node->data.binary_expr.operator));
+    generate_binary_operand(output, right, right_type, result_type, right_parens, indent_level);
 }
 
-static void generate_assignment(FILE* output, ASTNode* node, int indent_level) {
+static void generate_assignment(Emitter* output, ASTNode* node, int indent_level) {
     if (!node || node->type != NODE_ASSIGNMENT) return;
 
     emit_indent(output, indent_level);
 
-    Symbol* target_symbol = lookup_symbol(getSymbolTable(), node->data.assignment.target);
-    DataType target_type = target_symbol->type;
-    DataType value_type = get_expression_type(node->data.assignment.value, getSymbolTable());
+    DataType target_type = node->data.assignment.target_type;
+    DataType value_type = expression_type(node->data.assignment.value);
 
-    fprintf(output, "%s" C_ASSIGN, mangle_identifier(node->data.assignment.target, false));
+    emit_identifier(output, node->data.assignment.target, false);
+    emit_lit(output, C_ASSIGN);
 
     generate_cast_if_needed(output, value_type, target_type);
 
     generate(output, node->data.assignment.value, 0);
-    fprintf(output, C_SEMICOLON_NL);
+    emit_lit(output, C_SEMICOLON_NL);
+}
+
+// function definitions go through the function cache when one is in use: a hit
+// is copied verbatim, a miss is generated into scratch memory and stored
+static void generate_function_definition(Emitter* output, ASTNode* function, int indent_level) {
+    const char* cached = function->data.function.cached_code;
+    if (cached) {
+        emit_raw(output, cached, function->data.function.cached_length);
+        return;
+    }
+
+    TranspilerContext* ctx = current_context();
+    if (!ctx->cache) {
+        generate(output, function, indent_level);
+        return;
+    }
+
+    if (!ctx->scratch && !(ctx->scratch = emitter_create_memory())) {
+        generate(output, function, indent_level);
+        return;
+    }
+
+    Emitter* scratch = ctx->scratch;
+    emitter_reset(scratch);
+    generate(scratch, function, indent_level);
+
+    // never cache code from a compilation that reported errors
+    if (!scratch->failed && ctx->parser_state.error_count == 0) {
+        function_cache_store(ctx->cache, function->data.function.cache_key,
+                             scratch->data, scratch->length);
+    }
+    emit_raw(output, scratch->data, scratch->length);
 }
 
-void generate(FILE* output, ASTNode* node, int indent_level) {
+void generate(Emitter* output, ASTNode* node, int indent_level) {
     if (!node) return;
 
 
@@ -161,8 +201,8 @@ void generate(FILE* output, ASTNode* node, int indent_level) {
             // validate entry point exists
             ASTNode* entry_point = find_entry_point(node->data.program.functions);
             if (entry_point == NULL) {
-                fprintf(stderr, "Error: Entry point function 'w()' not defined\n");
-                exit(1);
+                fprintf(current_context()->diagnostics, "Error: Entry point function 'w()' not defined\n");
+                context_abort(current_context());
             }
 
             emit_c_includes(output);
@@ -172,46 +212,54 @@ void generate(FILE* output, ASTNode* node, int indent_level) {
                 ASTNode* global = node->data.program.globals;
                 while (global) {
                     generate(output, global, 0);
-                    fprintf(output, C_NEWLINE);
+                    emit_lit(output, C_NEWLINE);
                     global = global->next;
                 }
-                fprintf(output, C_NEWLINE);
+                emit_lit(output, C_NEWLINE);
             }
 
-            // emit forward declarations for all non-w functions
+            // emit forward declarations for all non-w functions that are
+            // called before their definition (all of them unless the
+            // whole-program pass ordered callees first)
             ASTNode* function = node->data.program.functions;
+            bool declared = false;
             while (function != NULL) {
-                if (strcmp(function->data.function.name, "w") != 0) {
+                if (function != entry_point && function->data.function.needs_prototype) {
                     const TypeMapping* mapping = type_registry_get_by_wlang_name(
                         function->data.function.return_type
                     );
                     const char* c_return_type = mapping ? mapping->c_equivalent :
                                                 function->data.function.return_type;
 
-                    const char* c_func_name = mangle_identifier(function->data.function.name, true);
-
+                    emit_function_linkage(output, function);
                     emit_function_declaration(output, c_return_type,
-                                            c_func_name,
+                                            function->data.function.name,
                                             function->data.function.parameters,
                                             function->data.function.param_count);
+                    declared = true;
                 }
                 function = function->next;
             }
-            fprintf(output, C_NEWLINE);
+            if (declared) {
+                emit_lit(output, C_NEWLINE);
+            }
 
             // emit definitions for all non-w functions
             function = node->data.program.functions;
             while (function != NULL) {
-                if (strcmp(function->data.function.name, "w") != 0) {
-                    generate(output, function, indent_level);
-                    fprintf(output, C_NEWLINE);
+                if (function != entry_point) {
+                    // linkage depends on the callers, so it stays out of the
+                    // cached definition
+                    emit_function_linkage(output, function);
+                    generate_function_definition(output, function, indent_level);
+                    emit_lit(output, C_NEWLINE);
                 }
                 function = function->next;
             }
 
             // emit w() function definition last (becomes main)
-            generate(output, entry_point, indent_level);
-            fprintf(output, C_NEWLINE);
+            generate_function_definition(output, entry_point, indent_level);
+            emit_lit(output, C_NEWLINE);
             break;
         }
         case NODE_FUNCTION: {
@@ -219,11 +267,8 @@ void generate(FILE* output, ASTNode* node, int indent_level) {
             const TypeMapping* mapping = type_registry_get_by_wlang_name(node->data.function.return_type);
             const char* c_return_type = mapping ? mapping->c_equivalent : node->data.function.return_type;
 
-            // mangle function name
-            const char* c_func_name = mangle_identifier(node->data.function.name, true);
-
-            // generate function signature using formatter
-            emit_function_signature(output, c_return_type, c_func_name,
+            // generate function signature using formatter (mangles the name)
+            emit_function_signature(output, c_return_type, node->data.function.name,
                                    node->data.function.parameters, node->data.function.param_count);
 
             // generate function body
@@ -232,7 +277,7 @@ void generate(FILE* output, ASTNode* node, int indent_level) {
                 generate(output, statement, indent_level + 1);
                 statement = statement->next;
             }
-            fprintf(output, C_RBRACE);
+            emit_lit(output, C_RBRACE);
             break;
         }
         case NODE_LOG:
@@ -240,14 +285,12 @@ void generate(FILE* output, ASTNode* node, int indent_level) {
             break;
         case NODE_VAR_DECLARATION: {
             emit_indent(output, indent_level);
-            fprintf(
-                output, "%s %s",
-                get_c_type_string(node->data.var_declaration.type),
-                mangle_identifier(node->data.var_declaration.name, false)
-            );
+            emit_str(output, get_c_type_string(node->data.var_declaration.type));
+            emit_lit(output, C_SPACE);
+            emit_identifier(output, node->data.var_declaration.name, false);
 
             if (node->data.var_declaration.init_expr) {
-                fprintf(output, C_ASSIGN);
+                emit_lit(output, C_ASSIGN);
                 generate_expression_with_cast(
                     output,
                     node->data.var_declaration.init_expr,
@@ -256,67 +299,59 @@ void generate(FILE* output, ASTNode* node, int indent_level) {
             } else {
                 const char* default_val = get_default_value_from_enum(node->data.var_declaration.type);
                 if (default_val && strlen(default_val) > 0) {
-                    fprintf(output, C_ASSIGN "%s", default_val);
+                    emit_lit(output, C_ASSIGN);
+                    emit_str(output, default_val);
                 }
             }
-            fprintf(output, C_SEMICOLON_NL);
+            emit_lit(output, C_SEMICOLON_NL);
             break;
         }
         case NODE_BINARY_EXPR:
             generate_binary_expr(output, node, indent_level);
             break;
         case NODE_NUMBER:
-            fprintf(output, "%d", node->data.number.value);
+            emit_int(output, node->data.number.value);
             break;
         case NODE_STRING:
-            fprintf(output, C_STRING_QUOTE);
-            for (const char* p = node->data.string.value; *p; p++) {
-                switch (*p) {
-                    case '\n': fprintf(output, C_ESC_NEWLINE); break;
-                    case '\t': fprintf(output, C_ESC_TAB); break;
-                    case '\"': fprintf(output, C_ESC_QUOTE); break;
-                    case '\\': fprintf(output, C_ESC_BACKSLASH); break;
-                    default: fputc(*p, output);
-                }
-            }
-            fprintf(output, C_STRING_QUOTE);
+            emit_lit(output, C_STRING_QUOTE);
+            emit_escaped(output, node->data.string.value);
+            emit_lit(output, C_STRING_QUOTE);
             break;
         case NODE_FLOAT:
-            fprintf(output, "%ff", node->data.float_val.value);
+            emit_format(output, "%ff", node->data.float_val.value);
             break;
         case NODE_CHAR:
-            fprintf(output, C_CHAR_QUOTE);
+            emit_lit(output, C_CHAR_QUOTE);
             if (node->data.char_val.value == '\n') {
-                fprintf(output, C_ESC_NEWLINE);
+                emit_lit(output, C_ESC_NEWLINE);
             } else if (node->data.char_val.value == '\t') {
-                fprintf(output, C_ESC_TAB);
+                emit_lit(output, C_ESC_TAB);
             } else if (node->data.char_val.value == '\'') {
-                fprintf(output, C_ESC_SINGLE_QUOTE);
+                emit_lit(output, C_ESC_SINGLE_QUOTE);
             } else if (node->data.char_val.value == '\\') {
-                fprintf(output, C_ESC_BACKSLASH);
+                emit_lit(output, C_ESC_BACKSLASH);
             } else {
-                fprintf(output, "%c", node->data.char_val.value);
+                emit_char(output, node->data.char_val.value);
             }
-            fprintf(output, C_CHAR_QUOTE);
+            emit_lit(output, C_CHAR_QUOTE);
             break;
         case NODE_BOOL:
-            fprintf(output, "%s", node->data.bool_val.value ? C_TRUE : C_FALSE);
+            emit_str(output, node->data.bool_val.value ? C_TRUE : C_FALSE);
             break;
         case NODE_ASSIGNMENT: {
             generate_assignment(output, node, indent_level);
             break;
         }
         case NODE_VARIABLE:
-            fprintf(output, "%s", mangle_identifier(node->data.variable.name, false));
+            emit_identifier(output, node->data.variable.name, false);
             break;
         case NODE_RETURN: {
             emit_indent(output, indent_level);
-            fprintf(output, C_RETURN C_SPACE);
+            emit_lit(output, C_RETURN C_SPACE);
             if (node->data.return_statement.expression) {
-                // DataType type = get_expression_type(node->data.return_statement.expression, getSymbolTable());
                 generate(output, node->data.return_statement.expression, 0);
             }
-            fprintf(output, C_SEMICOLON_NL);
+            emit_lit(output, C_SEMICOLON_NL);
             break;
         }
         case NODE_FUNCTION_CALL: {
@@ -326,31 +361,32 @@ void generate(FILE* output, ASTNode* node, int indent_level) {
                 emit_indent(output, indent_level);
             }
 
-            fprintf(output, "%s" C_LPAREN, mangle_identifier(node->data.function_call.name, true));
+            emit_identifier(output, node->data.function_call.name, true);
+            emit_lit(output, C_LPAREN);
             for (int i = 0; i < node->data.function_call.arg_count; i++) {
                 if (i > 0) {
-                    fprintf(output, C_COMMA);
+                    emit_lit(output, C_COMMA);
                 }
                 generate(output, node->data.function_call.args[i], 0);
             }
-            fprintf(output, C_RPAREN);
+            emit_lit(output, C_RPAREN);
 
             if (indent_level > 0) {
-                fprintf(output, C_SEMICOLON_NL);
+                emit_lit(output, C_SEMICOLON_NL);
             }
             break;
         }
         default:
-            fprintf(stderr, "Unknown node type in AST\n");
-            exit(1);
+            fprintf(current_context()->diagnostics, "Unknown node type in AST\n");
+            context_abort(current_context());
     }
 }
 
-void generate_code(FILE* output, ASTNode* node) {
+void generate_code(Emitter* output, ASTNode* node) {
     if (!node) return;
 
     if (node->type != NODE_PROGRAM) {
-        fprintf(stderr, "Expected program node at root.\n");
+        fprintf(current_context()->diagnostics, "Expected program node at root.\n");
         return;
     }
 
@@ -0,0 +1,140 @@
+#include <stdatomic.h>
+#include <pthread.h>
+#include <time.h>
+#include <sys/resource.h>
+
+#include "instrument.h"
+
+bool instrument_timing = false;
+bool instrument_memory = false;
+
+static const char* phase_names[PHASE_COUNT] = {"lex", "parse", "semantic", "generate"};
+
+static const char* subsystem_names[MEM_SUBSYSTEM_COUNT] = {
+    "ast", "symbols", "registries", "map", "parser", "emitter"
+};
+
+// allocation counters are hit from every worker thread
+static atomic_size_t alloc_counts[MEM_SUBSYSTEM_COUNT];
+static atomic_size_t alloc_bytes[MEM_SUBSYSTEM_COUNT];
+
+// phase totals change once per phase per file, so a lock is cheap enough
+static pthread_mutex_t phase_lock = PTHREAD_MUTEX_INITIALIZER;
+static double phase_wall[PHASE_COUNT];
+static double phase_cpu[PHASE_COUNT];
+static int files_compiled = 0;
+
+// ==================== recording ====================
+
+void instrument_count_alloc(MemSubsystem subsystem, size_t bytes) {
+    atomic_fetch_add_explicit(&alloc_counts[subsystem], 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&alloc_bytes[subsystem], bytes, memory_order_relaxed);
+}
+
+void instrument_count_map_alloc(size_t bytes) {
+    instrument_count_alloc(MEM_MAP, bytes);
+}
+
+double instrument_wall_time(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+double instrument_cpu_time(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+void instrument_add_phase(Phase phase, double wall, double cpu) {
+    pthread_mutex_lock(&phase_lock);
+    phase_wall[phase] += wall;
+    phase_cpu[phase] += cpu;
+    pthread_mutex_unlock(&phase_lock);
+}
+
+void instrument_count_file(void) {
+    pthread_mutex_lock(&phase_lock);
+    files_compiled++;
+    pthread_mutex_unlock(&phase_lock);
+}
+
+// ==================== reporting ====================
+
+static long peak_rss_kb(void) {
+    struct rusage usage;
+    return getrusage(RUSAGE_SELF, &usage) == 0 ? usage.ru_maxrss : 0;
+}
+
+static void print_time_table(FILE* out) {
+    double total_wall = 0, total_cpu = 0;
+
+    fprintf(out, "%-12s %12s %12s\n", "phase", "wall ms", "cpu ms");
+    for (int i = 0; i < PHASE_COUNT; i++) {
+        fprintf(out, "%-12s %12.3f %12.3f\n", phase_names[i], phase_wall[i] * 1e3, phase_cpu[i] * 1e3);
+        total_wall += phase_wall[i];
+        total_cpu += phase_cpu[i];
+    }
+    fprintf(out, "%-12s %12.3f %12.3f\n", "total", total_wall * 1e3, total_cpu * 1e3);
+    fprintf(out, "(%d file%s)\n", files_compiled, files_compiled == 1 ? "" : "s");
+}
+
+static void print_memory_table(FILE* out) {
+    size_t total_count = 0, total_bytes = 0;
+
+    fprintf(out, "%-12s %12s %14s\n", "subsystem", "allocations", "bytes");
+    for (int i = 0; i < MEM_SUBSYSTEM_COUNT; i++) {
+        size_t count = atomic_load(&alloc_counts[i]);
+        size_t bytes = atomic_load(&alloc_bytes[i]);
+        fprintf(out, "%-12s %12zu %14zu\n", subsystem_names[i], count, bytes);
+        total_count += count;
+        total_bytes += bytes;
+    }
+    fprintf(out, "%-12s %12zu %14zu\n", "total", total_count, total_bytes);
+    fprintf(out, "peak RSS: %.1f MB\n", (double)peak_rss_kb() / 1024.0);
+}
+
+static void print_json(FILE* out) {
+    fprintf(out, "{\"files\": %d", files_compiled);
+
+    if (instrument_timing) {
+        fprintf(out, ", \"phases\": {");
+        for (int i = 0; i < PHASE_COUNT; i++) {
+            fprintf(out, "%s\"%s\": {\"wall_ms\": %.3f, \"cpu_ms\": %.3f}", i ? ", " : "",
+                    phase_names[i], phase_wall[i] * 1e3, phase_cpu[i] * 1e3);
+        }
+        fprintf(out, "}");
+    }
+
+    if (instrument_memory) {
+        fprintf(out, ", \"memory\": {");
+        for (int i = 0; i < MEM_SUBSYSTEM_COUNT; i++) {
+            fprintf(out, "%s\"%s\": {\"allocations\": %zu, \"bytes\": %zu}", i ? ", " : "",
+                    subsystem_names[i], atomic_load(&alloc_counts[i]), atomic_load(&alloc_bytes[i]));
+        }
+        fprintf(out, "}, \"peak_rss_kb\": %ld", peak_rss_kb());
+    }
+
+    fprintf(out, "}\n");
+}
+
+void instrument_print_report(FILE* out, ReportFormat format) {
+    if (!instrument_timing && !instrument_memory) return;
+
+    pthread_mutex_lock(&phase_lock);
+    if (format == REPORT_JSON) {
+        print_json(out);
+    } else {
+        if (instrument_timing) {
+            print_time_table(out);
+        }
+        if (instrument_timing && instrument_memory) {
+            fputc('\n', out);
+        }
+        if (instrument_memory) {
+            print_memory_table(out);
+        }
+    }
+    pthread_mutex_unlock(&phase_lock);
+}
@@ -4,64 +4,145 @@
 #include <unistd.h>
 
 #include "types.h"
-#include "symbol_table.h"
-#include "ast.h"
-#include "gen.h"
-#include "parser.h"
+#include "context.h"
+#include "batch.h"
+#include "output_path.h"
+#include "daemon/server.h"
+#include "instrument.h"
 #include "transpiler/type_registry.h"
 #include "transpiler/token_registry.h"
+#include "data_structures/hash.h"
+#include "data_structures/map.h"
 
-YYSTYPE yylval;
-TokenType token;
-char* output_file_name;
+static void print_usage(const char* program) {
+    fprintf(stderr, "Usage: %s [options] input.w output.c\n", program);
+    fprintf(stderr, "       %s [options] [-j N] -o outdir/ input.w...\n", program);
+    fprintf(stderr, "       %s [--cache-dir DIR] --serve socket\n", program);
+    fprintf(stderr, "Options: --mmap-output, --cache-dir DIR, --whole-program, --hot-cold\n");
+    fprintf(stderr, "Reports: --report-removed, --time-report, --mem-report, --report-format table|json\n");
+}
 
 int main(int argc, char* argv[]) {
-    if (argc != 3) {
-        fprintf(stderr, "Usage: %s input.w output.c\n", argv[0]);
+    TranspileOptions options = { .mode = EMITTER_BUFFERED };
+    const char* output_dir = NULL;
+    const char* socket_path = NULL;
+    int jobs = 0;
+    bool jobs_given = false;
+    ReportFormat report_format = REPORT_TABLE;
+
+    const char** inputs = malloc(sizeof(char*) * (argc > 1 ? argc : 1));
+    int input_count = 0;
+    if (!inputs) {
+        perror("Error allocating arguments");
         return 1;
     }
 
-    FILE* input = fopen(argv[1], "r");
-    if (!input) {
-        perror("Error opening input file.");
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--mmap-output") == 0) {
+            options.mode = EMITTER_MMAP;
+        } else if (strcmp(argv[i], "--cache-dir") == 0 && i + 1 < argc) {
+            options.cache_dir = argv[++i];
+        } else if (strcmp(argv[i], "--report-removed") == 0) {
+            options.report_removed = true;
+        } else if (strcmp(argv[i], "--whole-program") == 0) {
+            options.whole_program = true;
+        } else if (strcmp(argv[i], "--hot-cold") == 0) {
+            options.hot_cold = true;
+        } else if (strcmp(argv[i], "--time-report") == 0) {
+            instrument_timing = true;
+        } else if (strcmp(argv[i], "--mem-report") == 0) {
+            instrument_memory = true;
+        } else if (strcmp(argv[i], "--report-format") == 0 && i + 1 < argc) {
+            const char* value = argv[++i];
+            if (strcmp(value, "json") == 0) {
+                report_format = REPORT_JSON;
+            } else if (strcmp(value, "table") == 0) {
+                report_format = REPORT_TABLE;
+            } else {
+                fprintf(stderr, "Unknown report format: %s\n", value);
+                free(inputs);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--serve") == 0 && i + 1 < argc) {
+            socket_path = argv[++i];
+        } else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            output_dir = argv[++i];
+        } else if (strncmp(argv[i], "-j", 2) == 0) {
+            // accepts both "-j N" and "-jN"
+            const char* value = argv[i][2] ? argv[i] + 2 : (i + 1 < argc ? argv[++i] : "");
+            char* end;
+            long parsed = strtol(value, &end, 10);
+            if (*value == '\0' || *end != '\0' || parsed < 1) {
+                fprintf(stderr, "Invalid job count: %s\n", value);
+                free(inputs);
+                return 1;
+            }
+            jobs = (int)parsed;
+            jobs_given = true;
+        } else if (argv[i][0] == '-' && argv[i][1] != '\0') {
+            fprintf(stderr, "Unknown option: %s\n", argv[i]);
+            print_usage(argv[0]);
+            free(inputs);
+            return 1;
+        } else {
+            inputs[input_count++] = argv[i];
+        }
+    }
+
+    // without -o the positional arguments are exactly input and output;
+    // the server takes its inputs from clients
+    bool batch = output_dir != NULL;
+    bool server = socket_path != NULL;
+    if ((server && (batch || input_count != 0 || jobs_given)) ||
+        (!server && batch && input_count == 0) ||
+        (!server && !batch && (input_count != 2 || jobs_given))) {
+        print_usage(argv[0]);
+        free(inputs);
         return 1;
     }
 
-    output_file_name = argv[2];
-    FILE* output = fopen(output_file_name, "w");
-    if (!output) {
-        perror("Error opening output file.");
-        fclose(input);
+    // checked before any worker starts: two writers of one file would race
+    if (batch && !output_paths_distinct(output_dir, inputs, input_count)) {
+        free(inputs);
         return 1;
     }
 
+    // the registries are constant tables; these calls cost nothing
     type_registry_init();
     token_registry_init();
-    init_parser();
-    yyin = input;
-    token = yylex();
-    // printf("Token: %d\n", token);
-    ast = parse();
 
-    if (!ast || ast->type != NODE_PROGRAM) {
-        fprintf(stderr, "Failed to parse program.\n");
-        return 1;
+    // before any map exists; no output depends on map order
+    hash_seed_init();
+    if (instrument_memory) {
+        map_alloc_hook = instrument_count_map_alloc;
     }
 
-    generate_code(output, ast);
+    if (server) {
+        bool served = serve(socket_path, &options);
+        instrument_print_report(stderr, report_format);
 
-    free_ast(ast);
-    fclose(input);
-    fclose(output);
+        token_registry_cleanup();
+        type_registry_cleanup();
+        free(inputs);
+        return served ? 0 : 1;
+    }
+
+    int status;
+    if (batch) {
+        int failures = transpile_batch(inputs, input_count, output_dir, jobs, &options);
+        if (failures > 0) {
+            fprintf(stderr, "%d of %d files failed\n", failures, input_count);
+        }
+        status = failures > 0 ? 1 : 0;
+    } else {
+        status = transpile_file(inputs[0], inputs[1], &options) ? 0 : 1;
+    }
+
+    instrument_print_report(stderr, report_format);
 
-    cleanup_parser();
     token_registry_cleanup();
     type_registry_cleanup();
+    free(inputs);
 
-    // if (getParserState().error_count > 0) {
-    //     unlink(output_file_name);
-    //     return 1;
-    // }
-
-    return 0;
-}
\ No newline at end of file
+    return status;
+}
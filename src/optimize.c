@@ -0,0 +1,611 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <math.h>
+
+#include "optimize.h"
+#include "context.h"
+#include "semantic.h"
+#include "gen.h"
+#include "data_structures/map.h"
+
+// ==================== internal helper functions ====================
+
+static bool is_constant(const ASTNode* node) {
+    switch (node->type) {
+        case NODE_NUMBER:
+        case NODE_FLOAT:
+        case NODE_CHAR:
+        case NODE_BOOL:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// value of a num, chr or bool constant after promotion to num
+static long integer_value(const ASTNode* node) {
+    switch (node->type) {
+        case NODE_NUMBER: return node->data.number.value;
+        case NODE_CHAR:   return node->data.char_val.value;
+        case NODE_BOOL:   return node->data.bool_val.value ? 1 : 0;
+        default:          return 0;
+    }
+}
+
+// float literals reach the C compiler as "%ff" text, so a literal's value is
+// whatever that text reads back as, not the double the lexer parsed
+static float printed_float(double value) {
+    char text[64];
+    snprintf(text, sizeof(text), "%f", value);
+    return strtof(text, NULL);
+}
+
+static float real_value(const ASTNode* node) {
+    if (node->type == NODE_FLOAT) {
+        return printed_float(node->data.float_val.value);
+    }
+    return (float)integer_value(node);
+}
+
+// constant equal to a small whole number; -0.0 is not 0 here, since x - -0.0
+// is not always x
+static bool is_value(const ASTNode* node, int value) {
+    if (!is_constant(node)) return false;
+
+    float real = real_value(node);
+    return real == (float)value && !signbit(real);
+}
+
+// dropping a subtree must not drop a call
+static bool has_side_effects(const ASTNode* node) {
+    switch (node->type) {
+        case NODE_FUNCTION_CALL:
+        case NODE_ASSIGNMENT:
+            return true;
+        case NODE_BINARY_EXPR:
+            return has_side_effects(node->data.binary_expr.left) ||
+                   has_side_effects(node->data.binary_expr.right);
+        case NODE_UNARY_EXPR:
+            return has_side_effects(node->data.unary_expr.operand);
+        default:
+            return false;
+    }
+}
+
+// ==================== constant folding ====================
+
+static ASTNode* fold_integer(ASTNode* node, long left, long right) {
+    int result;
+    bool overflow;
+    switch (node->data.binary_expr.operator) {
+        case '+': overflow = __builtin_add_overflow((int)left, (int)right, &result); break;
+        case '-': overflow = __builtin_sub_overflow((int)left, (int)right, &result); break;
+        case '*': overflow = __builtin_mul_overflow((int)left, (int)right, &result); break;
+        case '/':
+            // leave division by zero for the C compiler to diagnose
+            if (right == 0) return node;
+            result = (int)(left / right);
+            overflow = false;
+            break;
+        default:
+            return node;
+    }
+
+    // INT_MIN has no literal form in C; "-2147483648" is a long
+    if (overflow || result == INT_MIN) return node;
+    return create_number_node(result, node->location);
+}
+
+static ASTNode* fold_real(ASTNode* node, float left, float right) {
+    float result;
+    switch (node->data.binary_expr.operator) {
+        case '+': result = left + right; break;
+        case '-': result = left - right; break;
+        case '*': result = left * right; break;
+        case '/':
+            if (right == 0.0f) return node;
+            result = left / right;
+            break;
+        default:
+            return node;
+    }
+
+    // only fold when the emitted literal reads back as the same float
+    if (!isfinite(result) || printed_float(result) != result) return node;
+    return create_float_node(result, node->location);
+}
+
+static ASTNode* fold_strings(ASTNode* node) {
+    const char* left = node->data.binary_expr.left->data.string.value;
+    const char* right = node->data.binary_expr.right->data.string.value;
+    size_t left_length = strlen(left);
+    size_t right_length = strlen(right);
+
+    char* joined = malloc(left_length + right_length);
+    if (!joined) return node;
+    memcpy(joined, left, left_length);
+    memcpy(joined + left_length, right, right_length);
+
+    ASTNode* folded = create_string_node(ast_intern_len(joined, left_length + right_length),
+                                         node->location);
+    free(joined);
+    return folded ? folded : node;
+}
+
+// x*1, x/1, x+0, x-0 and 1*x, 0+x; only when x already has the result type,
+// so dropping the operation drops no conversion
+static ASTNode* simplify_identity(ASTNode* node, DataType type) {
+    ASTNode* left = node->data.binary_expr.left;
+    ASTNode* right = node->data.binary_expr.right;
+    bool left_typed = expression_type(left) == type;
+    bool right_typed = expression_type(right) == type;
+
+    switch (node->data.binary_expr.operator) {
+        case '+':
+            // x + 0.0 turns -0.0 into 0.0, so only num
+            if (type != TYPE_NUM) break;
+            if (is_value(right, 0) && left_typed) return left;
+            if (is_value(left, 0) && right_typed) return right;
+            break;
+        case '-':
+            if (is_value(right, 0) && left_typed) return left;
+            break;
+        case '*':
+            // x * 0.0 is not 0 for infinities and NaN, so only num
+            if (type == TYPE_NUM && (is_value(left, 0) || is_value(right, 0)) &&
+                !has_side_effects(left) && !has_side_effects(right)) {
+                ASTNode* zero = create_number_node(0, node->location);
+                return zero ? zero : node;
+            }
+            if (is_value(right, 1) && left_typed) return left;
+            if (is_value(left, 1) && right_typed) return right;
+            break;
+        case '/':
+            if (is_value(right, 1) && left_typed) return left;
+            break;
+    }
+    return node;
+}
+
+static ASTNode* fold_expression(ASTNode* node) {
+    if (!node) return NULL;
+
+    switch (node->type) {
+        case NODE_BINARY_EXPR: {
+            node->data.binary_expr.left = fold_expression(node->data.binary_expr.left);
+            node->data.binary_expr.right = fold_expression(node->data.binary_expr.right);
+
+            ASTNode* left = node->data.binary_expr.left;
+            ASTNode* right = node->data.binary_expr.right;
+            DataType type = expression_type(node);
+
+            if (type == TYPE_STR) {
+                if (left->type == NODE_STRING && right->type == NODE_STRING) {
+                    return fold_strings(node);
+                }
+                return node;
+            }
+
+            if (is_constant(left) && is_constant(right)) {
+                ASTNode* folded = node;
+                if (type == TYPE_NUM) {
+                    folded = fold_integer(node, integer_value(left), integer_value(right));
+                } else if (type == TYPE_REAL) {
+                    folded = fold_real(node, real_value(left), real_value(right));
+                }
+                return folded ? folded : node;
+            }
+
+            return simplify_identity(node, type);
+        }
+        case NODE_UNARY_EXPR:
+            node->data.unary_expr.operand = fold_expression(node->data.unary_expr.operand);
+            return node;
+        case NODE_FUNCTION_CALL:
+            for (int i = 0; i < node->data.function_call.arg_count; i++) {
+                node->data.function_call.args[i] = fold_expression(node->data.function_call.args[i]);
+            }
+            return node;
+        case NODE_ASSIGNMENT:
+            node->data.assignment.value = fold_expression(node->data.assignment.value);
+            return node;
+        default:
+            return node;
+    }
+}
+
+// ==================== statements ====================
+
+static void fold_statement(ASTNode* node) {
+    switch (node->type) {
+        case NODE_VAR_DECLARATION:
+            node->data.var_declaration.init_expr = fold_expression(node->data.var_declaration.init_expr);
+            break;
+        case NODE_RETURN:
+            node->data.return_statement.expression = fold_expression(node->data.return_statement.expression);
+            break;
+        case NODE_LOG:
+            break;
+        default:
+            // call and assignment statements stay in place; only their
+            // operands are replaced
+            fold_expression(node);
+            break;
+    }
+}
+
+void fold_program(ASTNode* program) {
+    if (!program || program->type != NODE_PROGRAM) return;
+
+    // types are only trustworthy once annotation found nothing wrong
+    if (current_context()->parser_state.error_count > 0) return;
+
+    for (ASTNode* global = program->data.program.globals; global; global = global->next) {
+        fold_statement(global);
+    }
+
+    for (ASTNode* function = program->data.program.functions; function; function = function->next) {
+        if (function->data.function.cached_code) continue;
+        for (ASTNode* statement = function->data.function.body; statement; statement = statement->next) {
+            fold_statement(statement);
+        }
+    }
+}
+
+// ==================== dead function elimination ====================
+
+typedef struct {
+    Map* unvisited;             // name -> function node, until first reached
+    ASTNode** pending;          // reached functions whose bodies are not walked yet
+    size_t pending_count;
+    size_t pending_capacity;
+    bool failed;                // out of memory; keep every function
+} Reachability;
+
+static void reach_function(Reachability* state, const char* name) {
+    ASTNode* function = map_get(state->unvisited, name);
+    if (!function) return;
+
+    map_remove(state->unvisited, name);
+    if (state->pending_count == state->pending_capacity) {
+        size_t capacity = state->pending_capacity ? state->pending_capacity * 2 : 16;
+        ASTNode** grown = realloc(state->pending, sizeof(ASTNode*) * capacity);
+        if (!grown) {
+            state->failed = true;
+            return;
+        }
+        state->pending = grown;
+        state->pending_capacity = capacity;
+    }
+    state->pending[state->pending_count++] = function;
+}
+
+static void reach_calls(Reachability* state, ASTNode* node) {
+    if (!node) return;
+
+    switch (node->type) {
+        case NODE_FUNCTION_CALL:
+            reach_function(state, node->data.function_call.name);
+            for (int i = 0; i < node->data.function_call.arg_count; i++) {
+                reach_calls(state, node->data.function_call.args[i]);
+            }
+            break;
+        case NODE_BINARY_EXPR:
+            reach_calls(state, node->data.binary_expr.left);
+            reach_calls(state, node->data.binary_expr.right);
+            break;
+        case NODE_UNARY_EXPR:
+            reach_calls(state, node->data.unary_expr.operand);
+            break;
+        case NODE_ASSIGNMENT:
+            reach_calls(state, node->data.assignment.value);
+            break;
+        case NODE_VAR_DECLARATION:
+            reach_calls(state, node->data.var_declaration.init_expr);
+            break;
+        case NODE_RETURN:
+            reach_calls(state, node->data.return_statement.expression);
+            break;
+        default:
+            break;
+    }
+}
+
+static void report_removed(ASTNode* function) {
+    TranspilerContext* ctx = current_context();
+    const char* file = ctx->qualify_errors ? ctx->input_name : "";
+    const char* separator = ctx->qualify_errors ? ": " : "";
+    fprintf(ctx->diagnostics, "%s%sNote: removed unused function '%s' (line %d)\n",
+            file, separator, function->data.function.name, function->location.line);
+}
+
+void eliminate_dead_functions(ASTNode* program) {
+    if (!program || program->type != NODE_PROGRAM) return;
+
+    TranspilerContext* ctx = current_context();
+    ASTNode* entry_point = find_entry_point(program->data.program.functions);
+    if (!entry_point || ctx->parser_state.error_count > 0) return;
+
+    // names are interned, so functions are looked up by pointer
+    MapConfig config = {
+        .hash = hash_pointer,
+        .key_equal = key_equal_pointer
+    };
+    Reachability state = { .unvisited = map_create(64, config) };
+    if (!state.unvisited) return;
+
+    for (ASTNode* function = program->data.program.functions; function; function = function->next) {
+        map_put(state.unvisited, (void*)function->data.function.name, function);
+    }
+
+    reach_function(&state, entry_point->data.function.name);
+    for (ASTNode* global = program->data.program.globals; global; global = global->next) {
+        reach_calls(&state, global);
+    }
+    while (state.pending_count > 0) {
+        ASTNode* function = state.pending[--state.pending_count];
+        for (ASTNode* statement = function->data.function.body; statement; statement = statement->next) {
+            reach_calls(&state, statement);
+        }
+    }
+
+    // whatever is still unvisited was never called
+    ASTNode** link = &program->data.program.functions;
+    while (*link && !state.failed) {
+        ASTNode* function = *link;
+        if (map_get(state.unvisited, function->data.function.name) == function) {
+            if (ctx->report_removed) {
+                report_removed(function);
+            }
+            *link = function->next;
+        } else {
+            link = &function->next;
+        }
+    }
+
+    free(state.pending);
+    map_destroy(state.unvisited);
+}
+
+// ==================== whole-program linkage ====================
+
+// a leaf function with at most this many statements becomes static inline
+#define INLINE_MAX_STATEMENTS 4
+
+// with hot/cold attributes: executed at least this often is hot; executed
+// once and at least this long is cold
+#define HOT_CALL_COUNT 64
+#define COLD_MIN_STATEMENTS 32
+
+typedef struct FunctionInfo {
+    ASTNode* node;
+    struct FunctionInfo** callees;  // one entry per call site
+    size_t callee_count;
+    size_t callee_capacity;
+    size_t calls;                   // times executed per run of w(), saturating
+    int position;                   // index in the new definition order
+    int state;                      // 0 unvisited, 1 on the DFS stack, 2 done
+    size_t next_callee;             // DFS cursor
+} FunctionInfo;
+
+typedef struct {
+    FunctionInfo* infos;
+    Map* by_name;                   // name -> FunctionInfo
+    bool failed;
+} CallGraph;
+
+static void add_call_edge(CallGraph* graph, FunctionInfo* caller, const char* name) {
+    FunctionInfo* callee = map_get(graph->by_name, name);
+    if (!callee) return;
+
+    if (caller->callee_count == caller->callee_capacity) {
+        size_t capacity = caller->callee_capacity ? caller->callee_capacity * 2 : 4;
+        FunctionInfo** grown = realloc(caller->callees, sizeof(FunctionInfo*) * capacity);
+        if (!grown) {
+            graph->failed = true;
+            return;
+        }
+        caller->callees = grown;
+        caller->callee_capacity = capacity;
+    }
+    caller->callees[caller->callee_count++] = callee;
+}
+
+static void collect_calls(CallGraph* graph, FunctionInfo* caller, ASTNode* node) {
+    if (!node) return;
+
+    switch (node->type) {
+        case NODE_FUNCTION_CALL:
+            add_call_edge(graph, caller, node->data.function_call.name);
+            for (int i = 0; i < node->data.function_call.arg_count; i++) {
+                collect_calls(graph, caller, node->data.function_call.args[i]);
+            }
+            break;
+        case NODE_BINARY_EXPR:
+            collect_calls(graph, caller, node->data.binary_expr.left);
+            collect_calls(graph, caller, node->data.binary_expr.right);
+            break;
+        case NODE_UNARY_EXPR:
+            collect_calls(graph, caller, node->data.unary_expr.operand);
+            break;
+        case NODE_ASSIGNMENT:
+            collect_calls(graph, caller, node->data.assignment.value);
+            break;
+        case NODE_VAR_DECLARATION:
+            collect_calls(graph, caller, node->data.var_declaration.init_expr);
+            break;
+        case NODE_RETURN:
+            collect_calls(graph, caller, node->data.return_statement.expression);
+            break;
+        default:
+            break;
+    }
+}
+
+static size_t statement_count(const ASTNode* function) {
+    size_t count = 0;
+    for (const ASTNode* statement = function->data.function.body; statement; statement = statement->next) {
+        count++;
+    }
+    return count;
+}
+
+// post-order DFS from the entry point: every function lands after the
+// functions it calls, except along a recursive cycle.
+// returns: false if the graph has a cycle
+static bool order_callees_first(FunctionInfo* entry, FunctionInfo** order, int* ordered,
+                                FunctionInfo** stack) {
+    bool acyclic = true;
+    int depth = 0;
+
+    entry->state = 1;
+    stack[depth++] = entry;
+    while (depth > 0) {
+        FunctionInfo* info = stack[depth - 1];
+        if (info->next_callee < info->callee_count) {
+            FunctionInfo* callee = info->callees[info->next_callee++];
+            if (callee->state == 0) {
+                callee->state = 1;
+                stack[depth++] = callee;
+            } else if (callee->state == 1) {
+                acyclic = false;
+            }
+            continue;
+        }
+
+        info->state = 2;
+        info->position = *ordered;
+        order[(*ordered)++] = info;
+        depth--;
+    }
+    return acyclic;
+}
+
+// without loops or conditionals every call site runs once per run of its
+// caller, so an acyclic call graph gives exact execution counts
+static void count_calls(FunctionInfo** order, int count) {
+    order[count - 1]->calls = 1;
+    for (int i = count - 1; i >= 0; i--) {
+        FunctionInfo* caller = order[i];
+        for (size_t c = 0; c < caller->callee_count; c++) {
+            FunctionInfo* callee = caller->callees[c];
+            size_t sum = callee->calls + caller->calls;
+            callee->calls = sum < callee->calls ? SIZE_MAX : sum;
+        }
+    }
+}
+
+static void assign_linkage(FunctionInfo* info, FunctionInfo* entry, bool counted) {
+    ASTNode* function = info->node;
+    if (info == entry) return;
+
+    size_t statements = statement_count(function);
+    bool leaf = info->callee_count == 0;
+    function->data.function.linkage = leaf && statements <= INLINE_MAX_STATEMENTS
+        ? LINKAGE_INLINE
+        : LINKAGE_STATIC;
+
+    if (!counted || !current_context()->hot_cold) return;
+
+    if (info->calls >= HOT_CALL_COUNT) {
+        function->data.function.hotness = HOTNESS_HOT;
+    } else if (info->calls == 1 && statements >= COLD_MIN_STATEMENTS) {
+        function->data.function.hotness = HOTNESS_COLD;
+    }
+}
+
+void plan_whole_program(ASTNode* program) {
+    if (!program || program->type != NODE_PROGRAM) return;
+
+    TranspilerContext* ctx = current_context();
+    ASTNode* entry_point = find_entry_point(program->data.program.functions);
+    if (!entry_point || ctx->parser_state.error_count > 0) return;
+
+    int count = 0;
+    for (ASTNode* function = program->data.program.functions; function; function = function->next) {
+        count++;
+    }
+
+    MapConfig config = {
+        .hash = hash_pointer,
+        .key_equal = key_equal_pointer
+    };
+    CallGraph graph = {
+        .infos = calloc(count, sizeof(FunctionInfo)),
+        .by_name = map_create(count * 2, config)
+    };
+    FunctionInfo** order = malloc(sizeof(FunctionInfo*) * count);
+    FunctionInfo** stack = malloc(sizeof(FunctionInfo*) * count);
+    graph.failed = !graph.infos || !graph.by_name || !order || !stack;
+
+    int index = 0;
+    for (ASTNode* function = program->data.program.functions; function && !graph.failed;
+         function = function->next) {
+        graph.infos[index].node = function;
+        map_put(graph.by_name, (void*)function->data.function.name, &graph.infos[index]);
+        index++;
+    }
+    for (int i = 0; i < count && !graph.failed; i++) {
+        FunctionInfo* info = &graph.infos[i];
+        for (ASTNode* statement = info->node->data.function.body; statement; statement = statement->next) {
+            collect_calls(&graph, info, statement);
+        }
+    }
+
+    if (!graph.failed) {
+        FunctionInfo* entry = map_get(graph.by_name, entry_point->data.function.name);
+        int ordered = 0;
+        bool acyclic = order_callees_first(entry, order, &ordered, stack);
+
+        // anything the entry point cannot reach keeps its place, ahead of w()
+        // and with its prototype
+        if (ordered < count) {
+            order[ordered - 1] = NULL;
+            ordered--;
+            for (int i = 0; i < count; i++) {
+                if (graph.infos[i].state == 0) {
+                    graph.infos[i].position = ordered;
+                    order[ordered++] = &graph.infos[i];
+                }
+            }
+            entry->position = ordered;
+            order[ordered++] = entry;
+            acyclic = false;
+        }
+
+        if (acyclic) {
+            count_calls(order, count);
+        }
+
+        // relink callee-first; a callee only needs a prototype when a caller
+        // comes before it (recursion, or unreachable leftovers)
+        ASTNode** link = &program->data.program.functions;
+        for (int i = 0; i < count; i++) {
+            FunctionInfo* info = order[i];
+            info->node->data.function.needs_prototype = info->state == 0;
+            assign_linkage(info, entry, acyclic);
+            *link = info->node;
+            link = &info->node->next;
+        }
+        *link = NULL;
+
+        for (int i = 0; i < count; i++) {
+            FunctionInfo* caller = &graph.infos[i];
+            for (size_t c = 0; c < caller->callee_count; c++) {
+                if (caller->callees[c]->position > caller->position) {
+                    caller->callees[c]->node->data.function.needs_prototype = true;
+                }
+            }
+        }
+    }
+
+    for (int i = 0; graph.infos && i < count; i++) {
+        free(graph.infos[i].callees);
+    }
+    free(graph.infos);
+    free(order);
+    free(stack);
+    map_destroy(graph.by_name);
+}
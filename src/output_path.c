@@ -0,0 +1,84 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include "output_path.h"
+
+#define SOURCE_EXTENSION ".w"
+#define OUTPUT_EXTENSION ".c"
+
+char* output_path_for(const char* output_dir, const char* input) {
+    const char* base = strrchr(input, '/');
+    base = base ? base + 1 : input;
+
+    size_t base_len = strlen(base);
+    size_t ext_len = sizeof(SOURCE_EXTENSION) - 1;
+    if (base_len > ext_len && strcmp(base + base_len - ext_len, SOURCE_EXTENSION) == 0) {
+        base_len -= ext_len;
+    }
+
+    size_t dir_len = strlen(output_dir);
+    bool needs_slash = dir_len > 0 && output_dir[dir_len - 1] != '/';
+
+    size_t size = dir_len + needs_slash + base_len + sizeof(OUTPUT_EXTENSION);
+    char* path = malloc(size);
+    if (!path) return NULL;
+
+    snprintf(path, size, "%s%s%.*s%s", output_dir, needs_slash ? "/" : "",
+             (int)base_len, base, OUTPUT_EXTENSION);
+    return path;
+}
+
+typedef struct {
+    char* path;
+    int input;              // index into the inputs, to name both sides
+} OutputName;
+
+static int compare_output_names(const void* a, const void* b) {
+    const OutputName* left = a;
+    const OutputName* right = b;
+    int order = strcmp(left->path, right->path);
+    return order != 0 ? order : left->input - right->input;
+}
+
+bool output_paths_distinct(const char* output_dir, const char** inputs, int count) {
+    OutputName* names = malloc(sizeof(OutputName) * (count > 0 ? count : 1));
+    if (!names) {
+        perror("Error allocating output paths");
+        return false;
+    }
+
+    bool distinct = true;
+    int built = 0;
+    for (; built < count; built++) {
+        names[built].path = output_path_for(output_dir, inputs[built]);
+        names[built].input = built;
+        if (!names[built].path) {
+            perror("Error allocating output paths");
+            distinct = false;
+            break;
+        }
+    }
+
+    if (distinct) {
+        // sorted, every collision sits next to the first input that claimed the path
+        qsort(names, count, sizeof(OutputName), compare_output_names);
+        int first = 0;
+        for (int i = 1; i < count; i++) {
+            if (strcmp(names[first].path, names[i].path) != 0) {
+                first = i;
+            } else {
+                fprintf(stderr, "Error: '%s' and '%s' would both be written to '%s'\n",
+                        inputs[names[first].input], inputs[names[i].input], names[i].path);
+                distinct = false;
+            }
+        }
+    }
+
+    for (int i = 0; i < built; i++) {
+        free(names[i].path);
+    }
+    free(names);
+    return distinct;
+}
@@ -8,22 +8,26 @@
 #include "types.h"
 #include "ast.h"
 #include "parser.h"
+#include "context.h"
+#include "instrument.h"
 #include "transpiler/type_registry.h"
 #include "transpiler/token_registry.h"
 
-ParserState parser_state;
-
 void init_parser_state() {
-    parser_state.brace_depth = 0;
-    parser_state.block_capacity = 10;
-    parser_state.block_lines = malloc(sizeof(int) * parser_state.block_capacity);
-    parser_state.error_count = 0;
-    parser_state.in_function_body = 0;
-    parser_state.function_context = malloc(sizeof(FunctionContext));
-    parser_state.function_context->current_name = NULL;
-    parser_state.function_context->current_return_type = NULL;
-    parser_state.function_context->has_return = 0;
-    parser_state.function_context->return_value_required = 0;
+    TranspilerContext* ctx = current_context();
+    ctx->parser_state.brace_depth = 0;
+    ctx->parser_state.block_capacity = 10;
+    ctx->parser_state.block_lines = malloc(sizeof(int) * ctx->parser_state.block_capacity);
+    INSTRUMENT_ALLOC(MEM_PARSER, sizeof(int) * ctx->parser_state.block_capacity);
+    ctx->parser_state.error_count = 0;
+    ctx->parser_state.in_function_body = 0;
+    ctx->parser_state.report_line = 0;
+    ctx->parser_state.function_context = malloc(sizeof(FunctionContext));
+    INSTRUMENT_ALLOC(MEM_PARSER, sizeof(FunctionContext));
+    ctx->parser_state.function_context->current_name = NULL;
+    ctx->parser_state.function_context->current_return_type = NULL;
+    ctx->parser_state.function_context->has_return = 0;
+    ctx->parser_state.function_context->return_value_required = 0;
 }
 
 void init_parser() {
@@ -33,11 +37,10 @@ void init_parser() {
 }
 
 void cleanup_parser_state() {
-    free(parser_state.block_lines);
-    if (parser_state.function_context) {
-        free(parser_state.function_context->current_name);
-        free(parser_state.function_context->current_return_type);
-        free(parser_state.function_context);
+    TranspilerContext* ctx = current_context();
+    free(ctx->parser_state.block_lines);
+    if (ctx->parser_state.function_context) {
+        free(ctx->parser_state.function_context);
     }
 }
 
@@ -71,74 +74,89 @@ const char *tokenToString(TokenType token) {
     return token_registry_get_display_name(token);
 }
 
+// intern the current token's text; must be called before the token is eaten
+static const char* token_text(void) {
+    TranspilerContext* ctx = current_context();
+    return ast_intern_len(ctx->lval.slice.start, ctx->lval.slice.length);
+}
+
 void parser_error(const char* message) {
-    fprintf(stderr, "Error on line %d: %s\n", yylineno, message);
-    parser_state.error_count++;
-    if (parser_state.error_count >= 5) {
-        fprintf(stderr, "Too many errors, exiting.\n");
-        free_ast(ast);
-        // if (output_file_name != NULL) unlink(output_file_name);
-        cleanup_parser();
-        exit(1);
+    TranspilerContext* ctx = current_context();
+    int line = ctx->parser_state.report_line ? ctx->parser_state.report_line : context_line(ctx);
+    // batch mode interleaves files, so name the file in the same write
+    const char* file = ctx->qualify_errors ? ctx->input_name : "";
+    const char* separator = ctx->qualify_errors ? ": " : "";
+    fprintf(ctx->diagnostics, "%s%sError on line %d: %s\n", file, separator, line, message);
+    ctx->parser_state.error_count++;
+    if (ctx->parser_state.error_count >= 5) {
+        fprintf(ctx->diagnostics, "%s%sToo many errors, exiting.\n", file, separator);
+        // the driver releases the context and removes the output
+        context_abort(ctx);
     }
 }
 
 void enter_block() {
-    if (parser_state.brace_depth >= parser_state.block_capacity) {
-        parser_state.block_capacity *= 2;
-        parser_state.block_lines = realloc(parser_state.block_lines, sizeof(int) * parser_state.block_capacity);
-    }
-    parser_state.block_lines[parser_state.brace_depth++] = yylineno;
+    TranspilerContext* ctx = current_context();
+    if (ctx->parser_state.brace_depth >= ctx->parser_state.block_capacity) {
+        ctx->parser_state.block_capacity *= 2;
+        ctx->parser_state.block_lines = realloc(ctx->parser_state.block_lines, sizeof(int) * ctx->parser_state.block_capacity);
+        INSTRUMENT_ALLOC(MEM_PARSER, sizeof(int) * ctx->parser_state.block_capacity);
+    }
+    ctx->parser_state.block_lines[ctx->parser_state.brace_depth++] = context_line(ctx);
+    push_scope(getSymbolTable());
 }
 
 void exit_block() {
-    if (parser_state.brace_depth <= 0) {
+    TranspilerContext* ctx = current_context();
+    if (ctx->parser_state.brace_depth <= 0) {
         parser_error("Unexpected closing brace");
         return;
     }
-    parser_state.brace_depth--;
+    ctx->parser_state.brace_depth--;
+    pop_scope(getSymbolTable());
 }
 
 ASTNode* parse_factor() {
-    SourceLocation loc = {yylineno, 0, NULL};
-    switch (token) {
+    TranspilerContext* ctx = current_context();
+    SourceLocation loc = {context_line(ctx), 0, NULL};
+    switch (ctx->token) {
         case INT_LITERAL:
             {
-                ASTNode* node = create_number_node(yylval.number, loc);
+                ASTNode* node = create_number_node(ctx->lval.number, loc);
                 eat(INT_LITERAL);
                 return node;
             }
         case FLOAT_LITERAL:
             {
-                ASTNode* node = create_float_node(yylval.float_val, loc);
+                ASTNode* node = create_float_node(ctx->lval.float_val, loc);
                 eat(FLOAT_LITERAL);
                 return node;
             }
         case CHAR_LITERAL:
             {
-                ASTNode* node = create_char_node(yylval.char_val, loc);
+                ASTNode* node = create_char_node(ctx->lval.char_val, loc);
                 eat(CHAR_LITERAL);
                 return node;
             }
         case BOOL_LITERAL:
             {
-                ASTNode* node = create_bool_node(yylval.bool_val, loc);
+                ASTNode* node = create_bool_node(ctx->lval.bool_val, loc);
                 eat(BOOL_LITERAL);
                 return node;
             }
         case STRING_LITERAL:
             {
-                ASTNode* node = create_string_node(yylval.string, loc);
+                ASTNode* node = create_string_node(token_text(), loc);
                 eat(STRING_LITERAL);
                 return node;
             }
         case IDENTIFIER:
             {
-                char* name = strdup(yylval.string);
+                const char* name = token_text();
                 eat(IDENTIFIER);
 
                 // check if this is a function call
-                if (token == LPAREN) {
+                if (ctx->token == LPAREN) {
                     eat(LPAREN);
 
                     // parse arguments
@@ -146,20 +164,22 @@ ASTNode* parse_factor() {
                     int arg_count = 0;
                     int arg_capacity = 4;
 
-                    if (token != RPAREN) {
+                    if (ctx->token != RPAREN) {
                         args = malloc(sizeof(ASTNode*) * arg_capacity);
+                        INSTRUMENT_ALLOC(MEM_PARSER, sizeof(ASTNode*) * arg_capacity);
 
                         while (1) {
                             if (arg_count >= arg_capacity) {
                                 arg_capacity *= 2;
                                 args = realloc(args, sizeof(ASTNode*) * arg_capacity);
+                                INSTRUMENT_ALLOC(MEM_PARSER, sizeof(ASTNode*) * arg_capacity);
                             }
 
                             args[arg_count++] = parse_expression();
 
-                            if (token == COMMA) {
+                            if (ctx->token == COMMA) {
                                 eat(COMMA);
-                            } else if (token == RPAREN) {
+                            } else if (ctx->token == RPAREN) {
                                 break;
                             } else {
                                 parser_error("Expected ',' or ')' in function call");
@@ -170,14 +190,11 @@ ASTNode* parse_factor() {
 
                     eat(RPAREN);
                     ASTNode* node = create_function_call_node(name, args, arg_count, loc);
-                    free(name);
                     if (args) free(args);
                     return node;
                 } else {
                     // just a variable reference
-                    ASTNode* node = create_variable_node(name, loc);
-                    free(name);
-                    return node;
+                    return create_variable_node(name, loc);
                 }
             }
         case LPAREN:
@@ -194,61 +211,64 @@ ASTNode* parse_factor() {
 }
 
 ASTNode* parse_term() {
-    SourceLocation loc = {yylineno, 0, NULL};
+    TranspilerContext* ctx = current_context();
+    SourceLocation loc = {context_line(ctx), 0, NULL};
     ASTNode* node = parse_factor();
-    while (token == MULTIPLY || token == DIVIDE) {
-        char op = (token == MULTIPLY) ? '*' : '/';
-        eat(token);
+    while (ctx->token == MULTIPLY || ctx->token == DIVIDE) {
+        char op = (ctx->token == MULTIPLY) ? '*' : '/';
+        eat(ctx->token);
         node = create_binary_expr_node(node, parse_factor(), op, loc);
     }
     return node;
 }
 
 ASTNode* parse_expression() {
-    SourceLocation loc = {yylineno, 0, NULL};
+    TranspilerContext* ctx = current_context();
+    SourceLocation loc = {context_line(ctx), 0, NULL};
     ASTNode* node = parse_term();
-    while (token == PLUS || token == MINUS) {
-        char op = (token == PLUS) ? '+' : '-';
-        eat(token);
+    while (ctx->token == PLUS || ctx->token == MINUS) {
+        char op = (ctx->token == PLUS) ? '+' : '-';
+        eat(ctx->token);
         node = create_binary_expr_node(node, parse_term(), op, loc);
     }
     return node;
 }
 
 DataType parse_type_specifier() {
-    if (!is_type_token(token)) {
+    TranspilerContext* ctx = current_context();
+    if (!is_type_token(ctx->token)) {
         parser_error("Expected type specifier (num, real, chr, str, bool, zil)");
         return TYPE_ZIL;
     }
 
-    DataType var_type = token_to_data_type(token);
-    eat(token);
+    DataType var_type = token_to_data_type(ctx->token);
+    eat(ctx->token);
     return var_type;
 }
 
 ASTNode* parse_variable_declaration() {
-    SourceLocation loc = {yylineno, 0, NULL};
+    TranspilerContext* ctx = current_context();
+    SourceLocation loc = {context_line(ctx), 0, NULL};
     bool has_dec_keyword = false;
 
     // check if this is a dec declared variable
-    if (token == DEC) {
+    if (ctx->token == DEC) {
         has_dec_keyword = true;
         eat(DEC);
     }
 
     // parse variable name
-    if (token != IDENTIFIER) {
+    if (ctx->token != IDENTIFIER) {
         parser_error("Expected identifier in variable declaration");
         return NULL;
     }
     
-    char* var_name = strdup(yylval.string);
+    const char* var_name = token_text();
     eat(IDENTIFIER);
 
     // expect colon for type annotation
-    if (token != COLON) {
+    if (ctx->token != COLON) {
         parser_error("Expected ':' after variable name in declaration");
-        free(var_name);
         return NULL;
     }
 
@@ -256,35 +276,17 @@ ASTNode* parse_variable_declaration() {
 
     DataType var_type = parse_type_specifier();
     if (var_type == TYPE_ZIL) {
-        free(var_name);
         return NULL;
     }
 
     ASTNode* init_expr = NULL;
-    if (token == ASSIGNMENT) {
+    if (ctx->token == ASSIGNMENT) {
         eat(ASSIGNMENT);
         init_expr = parse_expression();
-
-        if (init_expr) {
-            DataType expr_type = get_expression_type(init_expr, getSymbolTable());
-            if (!compare_types(var_type, expr_type)) {
-                char error_msg[100];
-                snprintf(error_msg, sizeof(error_msg),
-                    "Type mismatch in initialization: cannot assign %s to %s",
-                    type_to_string(expr_type),
-                    type_to_string(var_type));
-                parser_error(error_msg);
-                free_ast(init_expr);
-                free(var_name);
-                return NULL;
-            }
-        }
     }
 
-    if (token != SEMICOLON) {
+    if (ctx->token != SEMICOLON) {
         parser_error("Expected semicolon after variable declaration");
-        if (init_expr) free_ast(init_expr);
-        free(var_name);
         return NULL;
     }
 
@@ -292,8 +294,6 @@ ASTNode* parse_variable_declaration() {
 
     if (!add_symbol(getSymbolTable(), var_name, var_type)) {
         parser_error("Variable already declared in this scope");
-        if (init_expr) free_ast(init_expr);
-        free(var_name);
         return NULL;
     }
 
@@ -301,45 +301,50 @@ ASTNode* parse_variable_declaration() {
 }
 
 ASTNode* parse_log() {
+    TranspilerContext* ctx = current_context();
     eat(LOG);
     eat(LPAREN);
 
     LogElement* head = NULL;
     LogElement* current = NULL;
 
-    while (token != RPAREN) {
-        LogElement* element = malloc(sizeof(LogElement));
+    while (ctx->token != RPAREN) {
+        LogElement* element;
 
-        if (token == STRING_LITERAL) {
-            element->type = NODE_STRING;
-            element->value.string = strdup(yylval.string);
+        if (ctx->token == STRING_LITERAL) {
+            element = create_log_element(NODE_STRING);
+            element->value.string = token_text();
             eat(STRING_LITERAL);
-        } else if (token == COMMA) {
+        } else if (ctx->token == COMMA) {
             // comma adds a space between elements
-            element->type = NODE_STRING;
-            element->value.string = strdup(" ");
+            element = create_log_element(NODE_STRING);
+            element->value.string = ast_intern(" ");
             eat(COMMA);
-        } else if (token == PLUS) {
+        } else if (ctx->token == PLUS) {
             // plus concatenates without space
             eat(PLUS);
             continue; // Don't create an element, just continue to next token
-        } else if (token == IDENTIFIER) {
+        } else if (ctx->token == IDENTIFIER) {
             // handle variable reference
-            element->type = NODE_VARIABLE;
-            element->value.string = strdup(yylval.string);
+            element = create_log_element(NODE_VARIABLE);
+            element->value.string = token_text();
+            Symbol* symbol = lookup_symbol(getSymbolTable(), element->value.string);
+            if (symbol == NULL) {
+                parser_error("Undefined variable in log statement");
+            } else {
+                element->var_type = symbol->type;
+            }
             eat(IDENTIFIER);
-        } else if (token == INT_LITERAL) {
+        } else if (ctx->token == INT_LITERAL) {
             // handle number literal
-            element->type = NODE_NUMBER;
-            element->value.number = yylval.number;
+            element = create_log_element(NODE_NUMBER);
+            element->value.number = ctx->lval.number;
             eat(INT_LITERAL);
         } else {
             parser_error("Invalid token in log statement");
-            free(element);
             break;
         }
 
-        element->next = NULL;
         if (head == NULL) {
             head = element;
             current = element;
@@ -356,26 +361,28 @@ ASTNode* parse_log() {
 }
 
 ASTNode* parse_return_statement() {
+    TranspilerContext* ctx = current_context();
+    SourceLocation loc = {context_line(ctx), 0, NULL};
     eat(RETURN);
     ASTNode* expr = NULL;
     int has_value = 0;
 
-    if (token != SEMICOLON) {
+    if (ctx->token != SEMICOLON) {
         expr = parse_expression();
         has_value = 1;
     }
 
     eat(SEMICOLON);
 
-    if (parser_state.function_context) {
-        parser_state.function_context->has_return = 1;
+    if (ctx->parser_state.function_context) {
+        ctx->parser_state.function_context->has_return = 1;
 
-        if (strcmp(parser_state.function_context->current_return_type, "zil") == 0) {
+        if (strcmp(ctx->parser_state.function_context->current_return_type, "zil") == 0) {
             if (has_value) {
                 char error_msg[100];
                 snprintf(error_msg, sizeof(error_msg),
                     "Function '%s' declared as void, cannot return a value",
-                    parser_state.function_context->current_name);
+                    ctx->parser_state.function_context->current_name);
                 parser_error(error_msg);
             }
         } else {
@@ -383,57 +390,41 @@ ASTNode* parse_return_statement() {
                 char error_msg[100];
                 snprintf(error_msg, sizeof(error_msg),
                     "Function '%s' with return type '%s' must return a value",
-                    parser_state.function_context->current_name,
-                    parser_state.function_context->current_return_type);
+                    ctx->parser_state.function_context->current_name,
+                    ctx->parser_state.function_context->current_return_type);
                 parser_error(error_msg);
-            } else if (expr) {
-                DataType expr_type = get_expression_type(expr, getSymbolTable());
-                DataType func_type = type_registry_string_to_enum(parser_state.function_context->current_return_type);
-
-                if (expr_type != func_type) {
-                    char error_msg[100];
-                    snprintf(error_msg, sizeof(error_msg),
-                        "Return type mismatch in function '%s'. Expected %s, got %s",
-                        parser_state.function_context->current_name,
-                        parser_state.function_context->current_return_type,
-                        get_wlang_type_from_enum(expr_type));
-                    parser_error(error_msg);
-                }
             }
+            // the value's type is checked by the annotation pass
         }
     }
 
-    ASTNode* node = malloc(sizeof(ASTNode));
-    node->type = NODE_RETURN;
-    node->data.return_statement.expression = expr;
-    node->next = NULL;
-    return node;
+    return create_return_node(expr, loc);
 }
 
 Parameter* parse_parameter_list(int* param_count) {
+    TranspilerContext* ctx = current_context();
     Parameter* head = NULL;
     Parameter* tail = NULL;
     *param_count = 0;
 
     // if next token is RPAREN, no parameters
-    if (token == RPAREN) {
+    if (ctx->token == RPAREN) {
         return NULL;
     }
 
     while (1) {
         // expect parameter name
-        if (token != IDENTIFIER) {
+        if (ctx->token != IDENTIFIER) {
             parser_error("Expected parameter name");
             return head;
         }
 
-        char* param_name = strdup(yylval.string);
+        const char* param_name = token_text();
         eat(IDENTIFIER);
 
         // expect colon
-        if (token != COLON) {
+        if (ctx->token != COLON) {
             parser_error("Expected ':' after parameter name");
-            free(param_name);
             return head;
         }
         eat(COLON);
@@ -442,20 +433,14 @@ Parameter* parse_parameter_list(int* param_count) {
         DataType param_type = parse_type_specifier();
 
         // create parameter node
-        Parameter* param = malloc(sizeof(Parameter));
+        Parameter* param = create_parameter(param_name, param_type);
         if (!param) {
-            parser_error("Memory allocation failed for parameter");
-            free(param_name);
             return head;
         }
-        param->name = param_name;
-        param->type = param_type;
-        param->next = NULL;
 
         // add to symbol table
         if (!add_symbol(getSymbolTable(), param_name, param_type)) {
             parser_error("Duplicate parameter name");
-            free(param);
             return head;
         }
 
@@ -470,10 +455,10 @@ Parameter* parse_parameter_list(int* param_count) {
         (*param_count)++;
 
         // check for comma (more parameters) or closing paren
-        if (token == COMMA) {
+        if (ctx->token == COMMA) {
             eat(COMMA);
             continue;
-        } else if (token == RPAREN) {
+        } else if (ctx->token == RPAREN) {
             break;
         } else {
             parser_error("Expected ',' or ')' after parameter");
@@ -485,15 +470,16 @@ Parameter* parse_parameter_list(int* param_count) {
 }
 
 ASTNode* parse_statement() {
-    SourceLocation loc = {yylineno, 0, NULL};
-    switch (token) {
+    TranspilerContext* ctx = current_context();
+    SourceLocation loc = {context_line(ctx), 0, NULL};
+    switch (ctx->token) {
         case LBRACE:
             eat(LBRACE);
             enter_block();
-            while (token != RBRACE && token != EOF) {
+            while (ctx->token != RBRACE && ctx->token != EOF) {
                 parse_statement();
             }
-            if (token == EOF) {
+            if (ctx->token == EOF) {
                 parser_error("Unexpected end of file. Missing closing brace.");
                 return NULL;
             }
@@ -514,17 +500,15 @@ ASTNode* parse_statement() {
         case RETURN:
             return parse_return_statement();
         case IDENTIFIER: {
-            char*name = strdup(yylval.string);
+            const char* name = token_text();
             eat(IDENTIFIER);
 
-            if (token == ASSIGNMENT) {
+            if (ctx->token == ASSIGNMENT) {
                 eat(ASSIGNMENT);
                 ASTNode* value = parse_expression();
                 eat(SEMICOLON);
-                ASTNode* node = create_assignment_node(name, value, loc);
-                free(name);
-                return node;
-            } else if (token == LPAREN) {
+                return create_assignment_node(name, value, loc);
+            } else if (ctx->token == LPAREN) {
                 // handle function call
                 eat(LPAREN);
 
@@ -533,20 +517,22 @@ ASTNode* parse_statement() {
                 int arg_count = 0;
                 int arg_capacity = 4;
 
-                if (token != RPAREN) {
+                if (ctx->token != RPAREN) {
                     args = malloc(sizeof(ASTNode*) * arg_capacity);
+                    INSTRUMENT_ALLOC(MEM_PARSER, sizeof(ASTNode*) * arg_capacity);
 
                     while (1) {
                         if (arg_count >= arg_capacity) {
                             arg_capacity *= 2;
                             args = realloc(args, sizeof(ASTNode*) * arg_capacity);
+                            INSTRUMENT_ALLOC(MEM_PARSER, sizeof(ASTNode*) * arg_capacity);
                         }
 
                         args[arg_count++] = parse_expression();
 
-                        if (token == COMMA) {
+                        if (ctx->token == COMMA) {
                             eat(COMMA);
-                        } else if (token == RPAREN) {
+                        } else if (ctx->token == RPAREN) {
                             break;
                         } else {
                             parser_error("Expected ',' or ')' in function call");
@@ -558,46 +544,45 @@ ASTNode* parse_statement() {
                 eat(RPAREN);
                 eat(SEMICOLON);
                 ASTNode* node = create_function_call_node(name, args, arg_count, loc);
-                free(name);
                 if (args) free(args);
                 return node;
             }
 
             parser_error("Expected '=' or '(' after identifier");
-            free(name);
             return NULL;
         }
         default: {
             parser_error("Unexpected token in statement.");
-            eat(token);
+            eat(ctx->token);
             return NULL;    
         }
     }
 }
 
 ASTNode* parse_function() {
-    SourceLocation loc = {yylineno, 0, NULL};
+    TranspilerContext* ctx = current_context();
+    SourceLocation loc = {context_line(ctx), 0, NULL};
     
-    if (token != FUN) {
+    if (ctx->token != FUN) {
         parser_error("Expected 'fun' keyword for function definition");
         return NULL;
     }
     eat(FUN);
 
-    if (token != MAIN && token != IDENTIFIER) {
+    if (ctx->token != MAIN && ctx->token != IDENTIFIER) {
         parser_error("Expected function name after 'fun'");
         return NULL;
     }
 
-    char* name = strdup(yylval.string);
+    const char* name = token_text();
     // printf("Function name: %s\n", name);
     // eat "main" or identifier
-    eat(token);
+    eat(ctx->token);
     eat(LPAREN);
 
-    // ====================================
-    // TODO: SCOPED SYMBOL TABLE
-    // ====================================
+    // the function scope opens at the parameter list so parameters and
+    // top-level locals share one scope, as in C
+    enter_block();
 
     // parse parameters
     int param_count = 0;
@@ -605,21 +590,18 @@ ASTNode* parse_function() {
 
     eat(RPAREN);
 
-    char* return_type = strdup("zil");
+    const char* return_type = ast_intern("zil");
     DataType return_data_type = TYPE_ZIL;
-    if (token == COLON) {
+    if (ctx->token == COLON) {
         eat(COLON);
 
-        const char* type_str = token_to_type_string(token);
+        const char* type_str = token_to_type_string(ctx->token);
         if (type_str) {
-            free(return_type);
-            return_type = strdup(type_str);
-            return_data_type = token_to_data_type(token);
-            eat(token);
+            return_type = ast_intern(type_str);
+            return_data_type = token_to_data_type(ctx->token);
+            eat(ctx->token);
         } else {
             parser_error("Expected return type after ':'");
-            free(name);
-            free(return_type);
             return NULL;
         }
     }
@@ -632,30 +614,25 @@ ASTNode* parse_function() {
         parser_error(error_msg);
     }
 
-    if (parser_state.function_context) {
-        free(parser_state.function_context->current_name);
-        free(parser_state.function_context->current_return_type);
-        parser_state.function_context->current_name = strdup(name);
-        parser_state.function_context->current_return_type = strdup(return_type);
-        parser_state.function_context->has_return = 0;
-        parser_state.function_context->return_value_required = strcmp(return_type, "zil") != 0;
+    if (ctx->parser_state.function_context) {
+        ctx->parser_state.function_context->current_name = name;
+        ctx->parser_state.function_context->current_return_type = return_type;
+        ctx->parser_state.function_context->has_return = 0;
+        ctx->parser_state.function_context->return_value_required = strcmp(return_type, "zil") != 0;
     }
 
-    if (token != LBRACE) {
+    if (ctx->token != LBRACE) {
         parser_error("Expected '{' to begin function boddy");
-        free(name);
-        free(return_type);
         return NULL;
     }
     eat(LBRACE);
-    enter_block();
-    parser_state.in_function_body = 1;
+    ctx->parser_state.in_function_body = 1;
 
     int has_return = 0;
     ASTNode* body = NULL;
     ASTNode* last = NULL;
 
-    while (token != RBRACE && token != EOF) {
+    while (ctx->token != RBRACE && ctx->token != EOF) {
         ASTNode* statement = parse_statement();
         if (statement) {
             if (statement->type == NODE_RETURN) {
@@ -671,16 +648,14 @@ ASTNode* parse_function() {
         }
     }
 
-    if (token == EOF) {
+    if (ctx->token == EOF) {
         parser_error("Unexpected end of file.");
-        free(name);
-        free(return_type);
         return NULL;
     }
 
     eat(RBRACE);
     exit_block();
-    parser_state.in_function_body = 0;
+    ctx->parser_state.in_function_body = 0;
 
     // if (parser_state.brace_depth != 0) {
     //     parser_error("Mismatched braces in function body.");
@@ -690,9 +665,9 @@ ASTNode* parse_function() {
     //     error("Function must have a return statement.");
     // }
 
-    if (parser_state.function_context) {
-        if (parser_state.function_context->return_value_required &&
-            !parser_state.function_context->has_return) {
+    if (ctx->parser_state.function_context) {
+        if (ctx->parser_state.function_context->return_value_required &&
+            !ctx->parser_state.function_context->has_return) {
             char error_msg[200];
             snprintf(
                 error_msg, 
@@ -711,19 +686,20 @@ ASTNode* parse_function() {
         parameters,
         param_count,
         body,
-        parser_state.function_context->has_return,
+        ctx->parser_state.function_context->has_return,
         loc
     );
 }
 
 ASTNode* parse() {
-    SourceLocation loc = {yylineno, 0, NULL};
+    TranspilerContext* ctx = current_context();
+    SourceLocation loc = {context_line(ctx), 0, NULL};
     ASTNode* program = create_program_node(loc);
     if (!program) return NULL;
 
     ASTNode* last_function = NULL;
-    while (token != EOF) {
-        switch(token) {
+    while (ctx->token != EOF) {
+        switch(ctx->token) {
             case FUN: {
                 ASTNode* function = parse_function();
                 if (function) {
@@ -735,25 +711,24 @@ ASTNode* parse() {
                     last_function = function;
                 } else {
                     parser_error("Failed to parse function");
-                    free_ast(program);
                     return NULL;
                 }
                 break;
             }
             default: {
-                if (token == 0 || token == EOF) {
+                if (ctx->token == 0 || ctx->token == EOF) {
                     goto end;
                 }
 
                 char error_msg[100];
                 snprintf(error_msg, sizeof(error_msg),
                     "Unexpected token %s at top level. Expected 'fun' for function definition.",
-                    tokenToString(token));
+                    tokenToString(ctx->token));
                 parser_error(error_msg);
-                printf("Current token: %d, %s\n", token, tokenToString(token));
+                printf("Current token: %d, %s\n", ctx->token, tokenToString(ctx->token));
 
-                while (token != 0 && token != EOF) {
-                    token = yylex();
+                while (ctx->token != 0 && ctx->token != EOF) {
+                    context_advance(ctx);
                 }
             } break;
         }
@@ -764,21 +739,22 @@ ASTNode* parse() {
 }
 
 void eat(TokenType _token) {
-    if (token == _token) {
+    TranspilerContext* ctx = current_context();
+    if (ctx->token == _token) {
         // printf("Eating token: %s\n", tokenToString(token));
-        token = yylex();
+        context_advance(ctx);
         // printf("Token: %s\n", tokenToString(token));
     } else {
         char error_msg[100];
         snprintf(error_msg, sizeof(error_msg), 
             "Unexpected token. Expected %d (%s), got %d (%s)", 
             _token, tokenToString(_token), 
-            token, tokenToString(token));
+            ctx->token, tokenToString(ctx->token));
         parser_error(error_msg);
-        exit(1);
+        context_abort(ctx);
     }
 }
 
 ParserState getParserState(void) {
-    return parser_state;
+    return current_context()->parser_state;
 }
@@ -1,9 +1,22 @@
 #include "runtime/wlang_runtime.h"
+#include "data_structures/hash.h"
 #include <stdlib.h>
 #include <string.h>
 
+// keys boxed per call into the map's batch functions
+#define BATCH_CHUNK 64
+
+// ==================== startup ====================
+
+void wlang_runtime_init(void) {
+    hash_seed_init();
+}
+
 // ==================== map creation ====================
 
+// every runtime map resizes incrementally, so no single put in a W program
+// pays for rehashing the whole table
+
 Map* wlang_map_create_num_num(void) {
     MapConfig config = {
         .hash = hash_int,
@@ -11,9 +24,10 @@ Map* wlang_map_create_num_num(void) {
         .key_copy = NULL,        // integers stored as values
         .value_copy = NULL,      // integers stored as values
         .key_free = NULL,
-        .value_free = NULL
+        .value_free = NULL,
+        .incremental = true
     };
-    return map_create(16, config);
+    return map_create(0, config);
 }
 
 Map* wlang_map_create_num_str(void) {
@@ -21,47 +35,43 @@ Map* wlang_map_create_num_str(void) {
         .hash = hash_int,
         .key_equal = key_equal_int,
         .key_copy = NULL,        // integers stored as values
-        .value_copy = value_copy_string,  // deep copy strings
-        .key_free = NULL,
-        .value_free = value_free_string
+        .value_size = payload_size_string, // strings copied into the map's arena
+        .incremental = true
     };
-    return map_create(16, config);
+    return map_create(0, config);
 }
 
 Map* wlang_map_create_str_num(void) {
     MapConfig config = {
         .hash = hash_string,
         .key_equal = key_equal_string,
-        .key_copy = key_copy_string,  // deep copy strings
-        .value_copy = NULL,           // integers stored as values
-        .key_free = key_free_string,
-        .value_free = NULL
+        .key_size = payload_size_string,  // strings copied into the map's arena
+        .value_copy = NULL,               // integers stored as values
+        .incremental = true
     };
-    return map_create(16, config);
+    return map_create(0, config);
 }
 
 Map* wlang_map_create_str_str(void) {
     MapConfig config = {
         .hash = hash_string,
         .key_equal = key_equal_string,
-        .key_copy = key_copy_string,   // deep copy strings
-        .value_copy = value_copy_string, // deep copy strings
-        .key_free = key_free_string,
-        .value_free = value_free_string
+        .key_size = payload_size_string,   // strings copied into the map's arena
+        .value_size = payload_size_string,
+        .incremental = true
     };
-    return map_create(16, config);
+    return map_create(0, config);
 }
 
 Map* wlang_map_create_real_real(void) {
     MapConfig config = {
         .hash = hash_float,
         .key_equal = key_equal_float,
-        .key_copy = NULL,        // floats stored as pointers to heap-allocated values
-        .value_copy = NULL,
-        .key_free = NULL,
-        .value_free = NULL
+        .key_size = payload_size_float,    // floats copied into the map's arena
+        .value_size = payload_size_float,
+        .incremental = true
     };
-    return map_create(16, config);
+    return map_create(0, config);
 }
 
 Map* wlang_map_create_num_real(void) {
@@ -69,11 +79,10 @@ Map* wlang_map_create_num_real(void) {
         .hash = hash_int,
         .key_equal = key_equal_int,
         .key_copy = NULL,
-        .value_copy = NULL,
-        .key_free = NULL,
-        .value_free = NULL
+        .value_size = payload_size_float,  // floats copied into the map's arena
+        .incremental = true
     };
-    return map_create(16, config);
+    return map_create(0, config);
 }
 
 Map* wlang_map_create_chr_num(void) {
@@ -83,9 +92,10 @@ Map* wlang_map_create_chr_num(void) {
         .key_copy = NULL,
         .value_copy = NULL,
         .key_free = NULL,
-        .value_free = NULL
+        .value_free = NULL,
+        .incremental = true
     };
-    return map_create(16, config);
+    return map_create(0, config);
 }
 
 // ==================== put operations ====================
@@ -106,25 +116,13 @@ bool wlang_map_put_str_str(Map* map, const char* key, const char* value) {
     return map_put(map, (void*)key, (void*)value);
 }
 
+// the map copies the floats into its payload arena
 bool wlang_map_put_real_real(Map* map, float key, float value) {
-    // allocate heap memory for float keys and values
-    float* key_ptr = malloc(sizeof(float));
-    float* value_ptr = malloc(sizeof(float));
-    if (!key_ptr || !value_ptr) {
-        free(key_ptr);
-        free(value_ptr);
-        return false;
-    }
-    *key_ptr = key;
-    *value_ptr = value;
-    return map_put(map, key_ptr, value_ptr);
+    return map_put(map, &key, &value);
 }
 
 bool wlang_map_put_num_real(Map* map, int key, float value) {
-    float* value_ptr = malloc(sizeof(float));
-    if (!value_ptr) return false;
-    *value_ptr = value;
-    return map_put(map, (void*)(intptr_t)key, value_ptr);
+    return map_put(map, (void*)(intptr_t)key, &value);
 }
 
 bool wlang_map_put_chr_num(Map* map, char key, int value) {
@@ -132,10 +130,12 @@ bool wlang_map_put_chr_num(Map* map, char key, int value) {
 }
 
 // ==================== get operations ====================
+// integer values are found with map_find: a stored 0 is a NULL value and
+// must not turn into the default
 
 int wlang_map_get_num_num(Map* map, int key, int default_value) {
-    void* result = map_get(map, (void*)(intptr_t)key);
-    return result ? (int)(intptr_t)result : default_value;
+    MapEntry* entry = map_find(map, (void*)(intptr_t)key);
+    return entry ? (int)(intptr_t)entry->value : default_value;
 }
 
 const char* wlang_map_get_num_str(Map* map, int key, const char* default_value) {
@@ -144,8 +144,8 @@ const char* wlang_map_get_num_str(Map* map, int key, const char* default_value)
 }
 
 int wlang_map_get_str_num(Map* map, const char* key, int default_value) {
-    void* result = map_get(map, (void*)key);
-    return result ? (int)(intptr_t)result : default_value;
+    MapEntry* entry = map_find(map, key);
+    return entry ? (int)(intptr_t)entry->value : default_value;
 }
 
 const char* wlang_map_get_str_str(Map* map, const char* key, const char* default_value) {
@@ -164,8 +164,82 @@ float wlang_map_get_num_real(Map* map, int key, float default_value) {
 }
 
 int wlang_map_get_chr_num(Map* map, char key, int default_value) {
-    void* result = map_get(map, (void*)(intptr_t)key);
-    return result ? (int)(intptr_t)result : default_value;
+    MapEntry* entry = map_find(map, (void*)(intptr_t)key);
+    return entry ? (int)(intptr_t)entry->value : default_value;
+}
+
+// ==================== add operations ====================
+
+// one probe for m[k] = m[k] + delta; an absent key counts as 0
+static int add_to_entry(MapEntry* entry, int delta) {
+    if (!entry) return 0;
+
+    // in unsigned arithmetic, so overflow wraps instead of being undefined
+    int sum = (int)((unsigned int)(int)(intptr_t)entry->value + (unsigned int)delta);
+    entry->value = (void*)(intptr_t)sum;
+    return sum;
+}
+
+int wlang_map_add_num_num(Map* map, int key, int delta) {
+    return add_to_entry(map_get_or_insert(map, (void*)(intptr_t)key, NULL, NULL), delta);
+}
+
+int wlang_map_add_str_num(Map* map, const char* key, int delta) {
+    return add_to_entry(map_get_or_insert(map, (void*)key, NULL, NULL), delta);
+}
+
+int wlang_map_add_chr_num(Map* map, char key, int delta) {
+    return add_to_entry(map_get_or_insert(map, (void*)(intptr_t)key, NULL, NULL), delta);
+}
+
+// ==================== batch operations ====================
+
+static void unbox_found(MapEntry** entries, int count, int* values_out, int default_value) {
+    for (int i = 0; i < count; i++) {
+        values_out[i] = entries[i] ? (int)(intptr_t)entries[i]->value : default_value;
+    }
+}
+
+void wlang_map_get_many_num_num(Map* map, const int* keys, int count, int* values_out,
+                                int default_value) {
+    const void* boxed[BATCH_CHUNK];
+    MapEntry* entries[BATCH_CHUNK];
+
+    for (int start = 0; start < count; start += BATCH_CHUNK) {
+        int chunk = count - start < BATCH_CHUNK ? count - start : BATCH_CHUNK;
+        for (int i = 0; i < chunk; i++) {
+            boxed[i] = (const void*)(intptr_t)keys[start + i];
+        }
+        map_find_many(map, boxed, (size_t)chunk, entries);
+        unbox_found(entries, chunk, values_out + start, default_value);
+    }
+}
+
+void wlang_map_get_many_str_num(Map* map, const char* const* keys, int count, int* values_out,
+                                int default_value) {
+    MapEntry* entries[BATCH_CHUNK];
+
+    for (int start = 0; start < count; start += BATCH_CHUNK) {
+        int chunk = count - start < BATCH_CHUNK ? count - start : BATCH_CHUNK;
+        map_find_many(map, (const void* const*)(keys + start), (size_t)chunk, entries);
+        unbox_found(entries, chunk, values_out + start, default_value);
+    }
+}
+
+int wlang_map_put_many_num_num(Map* map, const int* keys, const int* values, int count) {
+    void* boxed_keys[BATCH_CHUNK];
+    void* boxed_values[BATCH_CHUNK];
+    int added = 0;
+
+    for (int start = 0; start < count; start += BATCH_CHUNK) {
+        int chunk = count - start < BATCH_CHUNK ? count - start : BATCH_CHUNK;
+        for (int i = 0; i < chunk; i++) {
+            boxed_keys[i] = (void*)(intptr_t)keys[start + i];
+            boxed_values[i] = (void*)(intptr_t)values[start + i];
+        }
+        added += (int)map_put_many(map, boxed_keys, boxed_values, (size_t)chunk);
+    }
+    return added;
 }
 
 // ==================== contains operations ====================
@@ -214,6 +288,10 @@ bool wlang_map_is_empty(Map* map) {
     return map_is_empty(map);
 }
 
+bool wlang_map_reserve(Map* map, int count) {
+    return map_reserve(map, count > 0 ? (size_t)count : 0);
+}
+
 void wlang_map_clear(Map* map) {
     map_clear(map);
 }
@@ -221,3 +299,91 @@ void wlang_map_clear(Map* map) {
 void wlang_map_destroy(Map* map) {
     map_destroy(map);
 }
+
+// ==================== concurrent maps ====================
+
+ConcurrentMap* wlang_cmap_create_num_num(void) {
+    MapConfig config = {
+        .hash = hash_int,
+        .key_equal = key_equal_int,
+        .incremental = true
+    };
+    return cmap_create(0, 0, config);
+}
+
+ConcurrentMap* wlang_cmap_create_str_num(void) {
+    MapConfig config = {
+        .hash = hash_string,
+        .key_equal = key_equal_string,
+        .key_size = payload_size_string,  // copied into the shard's arena
+        .incremental = true
+    };
+    return cmap_create(0, 0, config);
+}
+
+bool wlang_cmap_put_num_num(ConcurrentMap* cmap, int key, int value) {
+    return cmap_put(cmap, (void*)(intptr_t)key, (void*)(intptr_t)value);
+}
+
+bool wlang_cmap_put_str_num(ConcurrentMap* cmap, const char* key, int value) {
+    return cmap_put(cmap, (void*)key, (void*)(intptr_t)value);
+}
+
+int wlang_cmap_get_num_num(ConcurrentMap* cmap, int key, int default_value) {
+    void* value;
+    return cmap_lookup(cmap, (void*)(intptr_t)key, &value) ? (int)(intptr_t)value : default_value;
+}
+
+int wlang_cmap_get_str_num(ConcurrentMap* cmap, const char* key, int default_value) {
+    void* value;
+    return cmap_lookup(cmap, key, &value) ? (int)(intptr_t)value : default_value;
+}
+
+typedef struct {
+    int delta;
+    int sum;
+} CMapAdd;
+
+// runs under the shard's write lock
+static void add_under_lock(void** value, bool found, void* context) {
+    (void)found;  // a new entry starts at 0
+    CMapAdd* add = context;
+    add->sum = (int)((unsigned int)(int)(intptr_t)*value + (unsigned int)add->delta);
+    *value = (void*)(intptr_t)add->sum;
+}
+
+int wlang_cmap_add_num_num(ConcurrentMap* cmap, int key, int delta) {
+    CMapAdd add = {delta, 0};
+    cmap_upsert(cmap, (void*)(intptr_t)key, add_under_lock, &add);
+    return add.sum;
+}
+
+int wlang_cmap_add_str_num(ConcurrentMap* cmap, const char* key, int delta) {
+    CMapAdd add = {delta, 0};
+    cmap_upsert(cmap, (void*)key, add_under_lock, &add);
+    return add.sum;
+}
+
+bool wlang_cmap_contains_num(ConcurrentMap* cmap, int key) {
+    return cmap_contains(cmap, (void*)(intptr_t)key);
+}
+
+bool wlang_cmap_contains_str(ConcurrentMap* cmap, const char* key) {
+    return cmap_contains(cmap, key);
+}
+
+bool wlang_cmap_remove_num(ConcurrentMap* cmap, int key) {
+    return cmap_remove(cmap, (void*)(intptr_t)key);
+}
+
+bool wlang_cmap_remove_str(ConcurrentMap* cmap, const char* key) {
+    return cmap_remove(cmap, key);
+}
+
+size_t wlang_cmap_size(ConcurrentMap* cmap) {
+    return cmap_size(cmap);
+}
+
+void wlang_cmap_destroy(ConcurrentMap* cmap) {
+    cmap_destroy(cmap);
+}
@@ -0,0 +1,202 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "semantic.h"
+#include "context.h"
+#include "symbol_table.h"
+#include "parser.h"
+#include "operator_utils.h"
+#include "transpiler/type_registry.h"
+
+// ==================== cached type access ====================
+
+static Expression* expression_base(ASTNode* node) {
+    switch (node->type) {
+        case NODE_FUNCTION_CALL: return &node->data.function_call.base;
+        case NODE_BINARY_EXPR:   return &node->data.binary_expr.base;
+        case NODE_UNARY_EXPR:    return &node->data.unary_expr.base;
+        case NODE_NUMBER:        return &node->data.number.base;
+        case NODE_STRING:        return &node->data.string.base;
+        case NODE_FLOAT:         return &node->data.float_val.base;
+        case NODE_CHAR:          return &node->data.char_val.base;
+        case NODE_BOOL:          return &node->data.bool_val.base;
+        case NODE_VARIABLE:      return &node->data.variable.base;
+        case NODE_ASSIGNMENT:    return &node->data.assignment.base;
+        default:                 return NULL;
+    }
+}
+
+DataType expression_type(ASTNode* node) {
+    if (!node) return TYPE_ZIL;
+
+    Expression* base = expression_base(node);
+    return base ? base->expr_type : TYPE_ZIL;
+}
+
+// errors raised while annotating refer to the node's line, not the lexer's
+static void report_at(ASTNode* node) {
+    current_context()->parser_state.report_line = node->location.line;
+}
+
+// ==================== expressions ====================
+
+static DataType annotate_expression(ASTNode* node) {
+    if (!node) return TYPE_ZIL;
+
+    DataType type;
+    switch (node->type) {
+        case NODE_NUMBER:
+        case NODE_STRING:
+        case NODE_FLOAT:
+        case NODE_CHAR:
+        case NODE_BOOL:
+        case NODE_VARIABLE:
+            // literals are typed at creation, variables when they are resolved
+            return expression_type(node);
+        case NODE_BINARY_EXPR: {
+            DataType left = annotate_expression(node->data.binary_expr.left);
+            DataType right = annotate_expression(node->data.binary_expr.right);
+            report_at(node);
+            type = get_operation_type(
+                left,
+                right,
+                char_to_operator(node->data.binary_expr.operator)
+            );
+            break;
+        }
+        case NODE_UNARY_EXPR:
+            type = annotate_expression(node->data.unary_expr.operand);
+            break;
+        case NODE_FUNCTION_CALL: {
+            for (int i = 0; i < node->data.function_call.arg_count; i++) {
+                annotate_expression(node->data.function_call.args[i]);
+            }
+
+            FunctionSymbol* func = lookup_function(getFunctionTable(), node->data.function_call.name);
+            if (!func) {
+                char error_msg[100];
+                snprintf(
+                    error_msg,
+                    sizeof(error_msg),
+                    "Undefined function: '%s'",
+                    node->data.function_call.name
+                );
+                report_at(node);
+                parser_error(error_msg);
+                type = TYPE_ZIL;
+            } else {
+                type = func->return_type;
+            }
+            break;
+        }
+        case NODE_ASSIGNMENT: {
+            // for x = (y + z) * f, the AST would look like:
+            // NODE_ASSIGNMENT
+            // ├── target: "x"
+            // └── value: NODE_BINARY_EXPR (*)
+            //     ├── left: NODE_BINARY_EXPR (+)
+            //     │   ├── left: NODE_VARIABLE ("y")
+            //     │   └── right: NODE_VARIABLE ("z")
+            //     └── right: NODE_VARIABLE ("f")
+
+            DataType target_type = node->data.assignment.target_type;
+            DataType value_type = annotate_expression(node->data.assignment.value);
+            if (!compare_types(target_type, value_type)) {
+                char error_msg[100];
+                snprintf(error_msg, sizeof(error_msg),
+                        "Type mismatch in assignment to '%s': cannot assign %s to %s",
+                        node->data.assignment.target,
+                        type_to_string(value_type),
+                        type_to_string(target_type));
+                report_at(node);
+                parser_error(error_msg);
+            }
+            type = target_type;
+            break;
+        }
+        default:
+            parser_error("Unknown expression type");
+            return TYPE_ZIL;
+    }
+
+    expression_base(node)->expr_type = type;
+    return type;
+}
+
+// ==================== statements ====================
+
+static void annotate_statement(ASTNode* node, ASTNode* function) {
+    switch (node->type) {
+        case NODE_VAR_DECLARATION: {
+            ASTNode* init_expr = node->data.var_declaration.init_expr;
+            if (!init_expr) break;
+
+            DataType var_type = node->data.var_declaration.type;
+            DataType expr_type = annotate_expression(init_expr);
+            if (!compare_types(var_type, expr_type)) {
+                char error_msg[100];
+                snprintf(error_msg, sizeof(error_msg),
+                    "Type mismatch in initialization: cannot assign %s to %s",
+                    type_to_string(expr_type),
+                    type_to_string(var_type));
+                report_at(node);
+                parser_error(error_msg);
+            }
+            break;
+        }
+        case NODE_RETURN: {
+            ASTNode* expr = node->data.return_statement.expression;
+            if (!expr) break;
+
+            DataType expr_type = annotate_expression(expr);
+            if (!function) break;
+
+            // returning a value from a zil function is reported by the parser
+            DataType func_type = type_registry_string_to_enum(function->data.function.return_type);
+            if (func_type != TYPE_ZIL && expr_type != func_type) {
+                char error_msg[100];
+                snprintf(error_msg, sizeof(error_msg),
+                    "Return type mismatch in function '%s'. Expected %s, got %s",
+                    function->data.function.name,
+                    function->data.function.return_type,
+                    get_wlang_type_from_enum(expr_type));
+                report_at(node);
+                parser_error(error_msg);
+            }
+            break;
+        }
+        case NODE_LOG:
+            // log variables are resolved by the parser
+            break;
+        default:
+            annotate_expression(node);
+            break;
+    }
+}
+
+static void annotate_function(ASTNode* function) {
+    for (ASTNode* statement = function->data.function.body; statement; statement = statement->next) {
+        annotate_statement(statement, function);
+    }
+}
+
+bool annotate_program(ASTNode* program) {
+    if (!program || program->type != NODE_PROGRAM) return false;
+
+    TranspilerContext* ctx = current_context();
+    int errors = ctx->parser_state.error_count;
+
+    for (ASTNode* global = program->data.program.globals; global; global = global->next) {
+        annotate_statement(global, NULL);
+    }
+
+    for (ASTNode* function = program->data.program.functions; function; function = function->next) {
+        // a cached function was checked when its entry was written
+        if (function->data.function.cached_code) continue;
+        annotate_function(function);
+    }
+
+    ctx->parser_state.report_line = 0;
+    return ctx->parser_state.error_count == errors;
+}
@@ -0,0 +1,94 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "source.h"
+#include "types.h"
+
+// flex's scan buffer must end with two end-of-buffer (NUL) bytes
+#define SCAN_BUFFER_PADDING 2
+
+// ==================== internal helper functions ====================
+
+static bool source_map(SourceFile* source, int fd, size_t length) {
+    size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+    size_t mapped_size = (length + SCAN_BUFFER_PADDING + page_size - 1) & ~(page_size - 1);
+
+    // reserve zeroed anonymous pages first, then lay the file over the front.
+    // the tail past EOF stays anonymous, so the NUL padding is always backed
+    // even when the file ends exactly on a page boundary.
+    char* base = mmap(NULL, mapped_size, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED) return false;
+
+    // private + writable: flex briefly NUL-terminates yytext in place, and
+    // those writes must never reach the file
+    if (length > 0 &&
+        mmap(base, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED) {
+        munmap(base, mapped_size);
+        return false;
+    }
+
+    source->data = base;
+    source->length = length;
+    source->mapped_size = mapped_size;
+    source->stream = NULL;
+    return true;
+}
+
+// ==================== public API ====================
+
+bool source_open(SourceFile* source, const char* path) {
+    source->data = NULL;
+    source->length = 0;
+    source->mapped_size = 0;
+    source->stream = NULL;
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) &&
+        source_map(source, fd, (size_t)st.st_size)) {
+        close(fd);
+        return true;
+    }
+
+    // not mappable: let flex read it through stdio
+    source->stream = fdopen(fd, "r");
+    if (!source->stream) {
+        close(fd);
+        return false;
+    }
+    return true;
+}
+
+void source_from_memory(SourceFile* source, char* data, size_t length) {
+    source->data = data;
+    source->length = length;
+    source->mapped_size = 0;
+    source->stream = NULL;
+}
+
+bool source_attach_lexer(SourceFile* source, yyscan_t scanner) {
+    if (source->stream) {
+        yyset_in(source->stream, scanner);
+        return true;
+    }
+    return lexer_scan_buffer(source->data, source->length + SCAN_BUFFER_PADDING, scanner);
+}
+
+void source_close(SourceFile* source) {
+    if (source->stream) {
+        fclose(source->stream);
+        source->stream = NULL;
+    }
+    if (source->data && source->mapped_size > 0) {
+        munmap(source->data, source->mapped_size);
+    }
+    source->data = NULL;
+}
@@ -2,214 +2,148 @@
 #include <stdlib.h>
 #include <string.h>
 #include "symbol_table.h"
+#include "context.h"
 #include "parser.h"
 #include "operator_utils.h"
+#include "instrument.h"
 
-SymbolTable* symbol_table;
-FunctionTable* function_table;
+#define SCOPE_INITIAL_CAPACITY MAP_SMALL_CAPACITY
+#define FUNCTION_TABLE_INITIAL_CAPACITY 64
+
+// names are interned in the AST arena, so tables borrow them instead of
+// copying and compare them by address; symbols themselves are owned by the
+// table and freed with it
+static const MapConfig name_table_config = {
+    .hash = hash_pointer,
+    .key_equal = key_equal_pointer,
+    .key_copy = NULL,
+    .value_copy = NULL,
+    .key_free = NULL,
+    .value_free = free
+};
+
+// both tables live in the current context
 
 SymbolTable* getSymbolTable(void) {
-    return symbol_table;
+    return current_context()->symbol_table;
 }
 
 void create_symbol_table() {
-    symbol_table = malloc(sizeof(SymbolTable));
-    symbol_table->head = NULL;
-    return;
+    SymbolTable* table = malloc(sizeof(SymbolTable));
+    INSTRUMENT_ALLOC(MEM_SYMBOLS, sizeof(SymbolTable));
+    table->current = NULL;
+
+    // file scope, never popped until the table is freed
+    push_scope(table);
+    current_context()->symbol_table = table;
 }
 
 FunctionTable* getFunctionTable(void) {
-    return function_table;
+    return current_context()->function_table;
 }
 
 void create_function_table() {
-    function_table = malloc(sizeof(FunctionTable));
-    function_table->head = NULL;
+    FunctionTable* table = malloc(sizeof(FunctionTable));
+    INSTRUMENT_ALLOC(MEM_SYMBOLS, sizeof(FunctionTable));
+    table->functions = map_create(FUNCTION_TABLE_INITIAL_CAPACITY, name_table_config);
+    current_context()->function_table = table;
 }
 
 bool add_function(FunctionTable* table, const char* name, DataType return_type) {
     if (!table) return false;
 
-    // check if function already exists
-    FunctionSymbol* current = table->head;
-    while (current != NULL) {
-        if (strcmp(current->name, name) == 0) {
-            return false;  // Function already declared
-        }
-        current = current->next;
+    // one probe both checks for the function and claims its name
+    bool inserted;
+    MapEntry* entry = map_get_or_insert(table->functions, (void*)name, NULL, &inserted);
+    if (!entry || !inserted) {
+        return false;  // Function already declared
     }
 
     // create new function symbol
     FunctionSymbol* func = malloc(sizeof(FunctionSymbol));
-    if (!func) return false;
+    if (!func) {
+        map_remove(table->functions, name);
+        return false;
+    }
+    INSTRUMENT_ALLOC(MEM_SYMBOLS, sizeof(FunctionSymbol));
 
-    func->name = strdup(name);
+    func->name = name;
     func->return_type = return_type;
-    func->next = table->head;
-    table->head = func;
+    entry->value = func;
     return true;
 }
 
 FunctionSymbol* lookup_function(FunctionTable* table, const char* name) {
     if (!table) return NULL;
-
-    FunctionSymbol* current = table->head;
-    while (current != NULL) {
-        if (strcmp(current->name, name) == 0) {
-            return current;
-        }
-        current = current->next;
-    }
-    return NULL;
+    return map_get(table->functions, name);
 }
 
 void free_function_table(void) {
-    if (!function_table) return;
-
-    FunctionSymbol* current = function_table->head;
-    while (current != NULL) {
-        FunctionSymbol* next = current->next;
-        free(current->name);
-        free(current);
-        current = next;
-    }
-    free(function_table);
-    function_table = NULL;
+    TranspilerContext* ctx = current_context();
+    if (!ctx->function_table) return;
+
+    map_destroy(ctx->function_table->functions);
+    free(ctx->function_table);
+    ctx->function_table = NULL;
 }
 
 void free_symbol_table(void) {
-    Symbol* current = symbol_table->head;
-    while (current != NULL) {
-        Symbol* next = current->next;
-        free(current->name);
-        free(current);
-        current = next;
+    TranspilerContext* ctx = current_context();
+    if (!ctx->symbol_table) return;
+
+    while (ctx->symbol_table->current != NULL) {
+        pop_scope(ctx->symbol_table);
     }
-    free(symbol_table);
+    free(ctx->symbol_table);
+    ctx->symbol_table = NULL;
+}
+
+void push_scope(SymbolTable* table) {
+    Scope* scope = malloc(sizeof(Scope));
+    INSTRUMENT_ALLOC(MEM_SYMBOLS, sizeof(Scope));
+    scope->symbols = map_create(SCOPE_INITIAL_CAPACITY, name_table_config);
+    scope->parent = table->current;
+    scope->depth = table->current ? table->current->depth + 1 : 0;
+    table->current = scope;
+}
+
+void pop_scope(SymbolTable* table) {
+    Scope* scope = table->current;
+    if (!scope) return;
+
+    // drops every symbol declared in this block
+    table->current = scope->parent;
+    map_destroy(scope->symbols);
+    free(scope);
 }
 
 bool add_symbol(SymbolTable* table, const char* name, DataType type) {
-    if (lookup_symbol(table, name) != NULL) {
+    // only the innermost scope counts as a redeclaration; outer
+    // declarations of the same name are shadowed
+    bool inserted;
+    MapEntry* entry = map_get_or_insert(table->current->symbols, (void*)name, NULL, &inserted);
+    if (!entry || !inserted) {
         return false;
     }
 
     Symbol* symbol = malloc(sizeof(Symbol));
-    symbol->name = strdup(name);
+    INSTRUMENT_ALLOC(MEM_SYMBOLS, sizeof(Symbol));
+    symbol->name = name;
     symbol->type = type;
-    symbol->next = table->head;
-    table->head = symbol;
+    entry->value = symbol;
     return true;
 }
 
 Symbol* lookup_symbol(SymbolTable* table, const char* name) {
-    Symbol* current = table->head;
-    while (current != NULL) {
-        if (strcmp(current->name, name) == 0) {
-            return current;
+    for (Scope* scope = table->current; scope != NULL; scope = scope->parent) {
+        Symbol* symbol = map_get(scope->symbols, name);
+        if (symbol) {
+            return symbol;
         }
-        current = current->next;
     }
     return NULL;
 }
 
-DataType get_expression_type(ASTNode* node, SymbolTable* table) {
-    if (!node) return TYPE_ZIL;
-
-    switch (node->type) {
-        case NODE_NUMBER:
-            return TYPE_NUM;
-        case NODE_STRING:
-            return TYPE_STR;
-        case NODE_FLOAT:
-            return TYPE_REAL;
-        case NODE_CHAR:
-            return TYPE_CHR;
-        case NODE_BOOL:
-            return TYPE_BOOL;
-        case NODE_VARIABLE: {
-            Symbol* symbol = lookup_symbol(table, node->data.variable.name);
-            if (!symbol) {
-                char error_msg[100];
-                snprintf(
-                    error_msg, 
-                    sizeof(error_msg),
-                    "Undefined variable: '%s'",
-                    node->data.variable.name
-                );
-                parser_error(error_msg);
-                return TYPE_ZIL;
-            }
-            return symbol->type;
-        }
-        case NODE_BINARY_EXPR: {
-            DataType left = get_expression_type(node->data.binary_expr.left, table);
-            DataType right = get_expression_type(node->data.binary_expr.right, table);
-            return get_operation_type(
-                left, 
-                right,
-                char_to_operator(node->data.binary_expr.operator)
-            );
-        }
-        case NODE_ASSIGNMENT: {
-            // for x = (y + z) * f, the AST would look like:
-            // NODE_ASSIGNMENT
-            // ├── target: "x"
-            // └── value: NODE_BINARY_EXPR (*)
-            //     ├── left: NODE_BINARY_EXPR (+)
-            //     │   ├── left: NODE_VARIABLE ("y")
-            //     │   └── right: NODE_VARIABLE ("z")
-            //     └── right: NODE_VARIABLE ("f")
-
-            Symbol* symbol = lookup_symbol(table, node->data.assignment.target);
-            if (!symbol) {
-                char error_msg[100];
-                snprintf(
-                    error_msg,
-                    sizeof(error_msg),
-                    "Assignment to undefined variable '%s'",
-                    node->data.assignment.target
-                );
-                parser_error(error_msg);
-                return TYPE_ZIL;
-            }
-
-            DataType value_type = get_expression_type(node->data.assignment.value, table);
-            if (!can_convert_type(value_type, symbol->type)) {
-                char error_msg[100];
-                snprintf(
-                    error_msg,
-                    sizeof(error_msg),
-                    "Cannot assign %s to %s",
-                    type_to_string(value_type),
-                    type_to_string(symbol->type)
-                );
-                parser_error(error_msg);
-                return TYPE_ZIL;
-            }
-
-            return symbol->type;
-        }
-        case NODE_FUNCTION_CALL: {
-            FunctionSymbol* func = lookup_function(getFunctionTable(), node->data.function_call.name);
-            if (!func) {
-                char error_msg[100];
-                snprintf(
-                    error_msg,
-                    sizeof(error_msg),
-                    "Undefined function: '%s'",
-                    node->data.function_call.name
-                );
-                parser_error(error_msg);
-                return TYPE_ZIL;
-            }
-            return func->return_type;
-        }
-        default:
-            parser_error("Unknown expression type");
-            return TYPE_ZIL;
-    }
-}
-
 bool compare_types(DataType left, DataType right) {
     if (left == right) {
         return true;
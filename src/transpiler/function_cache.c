@@ -0,0 +1,293 @@
+#include "transpiler/function_cache.h"
+#include "symbol_table.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+// bump whenever code generation changes, so stale entries are never reused
+#define CACHE_FORMAT_VERSION "wlang-function-cache-3"
+
+#define FNV_OFFSET_BASIS 14695981039346656037ULL
+#define FNV_PRIME 1099511628211ULL
+
+// "<16 hex digits>.c"
+#define ENTRY_NAME_LENGTH 18
+
+// ==================== hashing ====================
+
+static uint64_t fold_bytes(uint64_t hash, const void* data, size_t len) {
+    const unsigned char* bytes = data;
+    for (size_t i = 0; i < len; i++) {
+        hash ^= bytes[i];
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+static uint64_t fold_int(uint64_t hash, long long value) {
+    return fold_bytes(hash, &value, sizeof(value));
+}
+
+// length-prefixed so adjacent strings cannot run together
+static uint64_t fold_string(uint64_t hash, const char* str) {
+    if (!str) return fold_int(hash, -1);
+
+    size_t len = strlen(str);
+    hash = fold_int(hash, (long long)len);
+    return fold_bytes(hash, str, len);
+}
+
+static uint64_t hash_node(uint64_t hash, ASTNode* node);
+
+// a call depends on what the function table says about its target
+static uint64_t hash_callee(uint64_t hash, const char* name) {
+    FunctionSymbol* callee = lookup_function(getFunctionTable(), name);
+    return fold_int(hash, callee ? (long long)callee->return_type : -1);
+}
+
+static uint64_t hash_log_elements(uint64_t hash, LogElement* element) {
+    for (; element; element = element->next) {
+        hash = fold_int(hash, element->type);
+        switch (element->type) {
+            case NODE_NUMBER:
+                hash = fold_int(hash, element->value.number);
+                break;
+            case NODE_VARIABLE:
+                hash = fold_string(hash, element->value.variable);
+                hash = fold_int(hash, element->var_type);
+                break;
+            default:
+                hash = fold_string(hash, element->value.string);
+                break;
+        }
+    }
+    return fold_int(hash, -1);
+}
+
+static uint64_t hash_node(uint64_t hash, ASTNode* node) {
+    if (!node) return fold_int(hash, -1);
+
+    hash = fold_int(hash, node->type);
+    switch (node->type) {
+        case NODE_FUNCTION:
+            hash = fold_string(hash, node->data.function.return_type);
+            hash = fold_string(hash, node->data.function.name);
+            hash = fold_int(hash, node->data.function.param_count);
+            for (Parameter* param = node->data.function.parameters; param; param = param->next) {
+                hash = fold_string(hash, param->name);
+                hash = fold_int(hash, param->type);
+            }
+            for (ASTNode* statement = node->data.function.body; statement; statement = statement->next) {
+                hash = hash_node(hash, statement);
+            }
+            hash = fold_int(hash, -1);
+            break;
+        case NODE_FUNCTION_CALL:
+            hash = fold_string(hash, node->data.function_call.name);
+            hash = hash_callee(hash, node->data.function_call.name);
+            hash = fold_int(hash, node->data.function_call.arg_count);
+            for (int i = 0; i < node->data.function_call.arg_count; i++) {
+                hash = hash_node(hash, node->data.function_call.args[i]);
+            }
+            break;
+        case NODE_LOG:
+            hash = hash_log_elements(hash, node->data.log.elements);
+            break;
+        case NODE_BINARY_EXPR:
+            hash = fold_int(hash, node->data.binary_expr.operator);
+            hash = hash_node(hash, node->data.binary_expr.left);
+            hash = hash_node(hash, node->data.binary_expr.right);
+            break;
+        case NODE_UNARY_EXPR:
+            hash = fold_int(hash, node->data.unary_expr.operator);
+            hash = hash_node(hash, node->data.unary_expr.operand);
+            break;
+        case NODE_NUMBER:
+            hash = fold_int(hash, node->data.number.value);
+            break;
+        case NODE_STRING:
+            hash = fold_string(hash, node->data.string.value);
+            break;
+        case NODE_FLOAT:
+            hash = fold_bytes(hash, &node->data.float_val.value, sizeof(double));
+            break;
+        case NODE_CHAR:
+            hash = fold_int(hash, node->data.char_val.value);
+            break;
+        case NODE_BOOL:
+            hash = fold_int(hash, node->data.bool_val.value);
+            break;
+        case NODE_VARIABLE:
+            hash = fold_string(hash, node->data.variable.name);
+            hash = fold_int(hash, node->data.variable.base.expr_type);
+            break;
+        case NODE_VAR_DECLARATION:
+            hash = fold_string(hash, node->data.var_declaration.name);
+            hash = fold_int(hash, node->data.var_declaration.type);
+            hash = hash_node(hash, node->data.var_declaration.init_expr);
+            break;
+        case NODE_ASSIGNMENT:
+            hash = fold_string(hash, node->data.assignment.target);
+            hash = fold_int(hash, node->data.assignment.target_type);
+            hash = hash_node(hash, node->data.assignment.value);
+            break;
+        case NODE_RETURN:
+            hash = hash_node(hash, node->data.return_statement.expression);
+            break;
+        default:
+            break;
+    }
+    return hash;
+}
+
+uint64_t function_cache_key(ASTNode* function) {
+    uint64_t hash = fold_string(FNV_OFFSET_BASIS, CACHE_FORMAT_VERSION);
+    return hash_node(hash, function);
+}
+
+// ==================== internal helper functions ====================
+
+static char* entry_path(FunctionCache* cache, uint64_t key) {
+    size_t size = strlen(cache->dir) + 1 + ENTRY_NAME_LENGTH + 1;
+    char* path = malloc(size);
+    if (!path) return NULL;
+
+    snprintf(path, size, "%s/%016llx.c", cache->dir, (unsigned long long)key);
+    return path;
+}
+
+// read a whole entry into the AST arena
+static bool load_entry(FunctionCache* cache, uint64_t key, const char** code, size_t* length) {
+    char* path = entry_path(cache, key);
+    if (!path) return false;
+
+    int fd = open(path, O_RDONLY);
+    free(path);
+    if (fd < 0) return false;
+
+    struct stat st;
+    char* data = NULL;
+    size_t size = 0;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode)) {
+        size = (size_t)st.st_size;
+        data = ast_alloc(size + 1);
+    }
+
+    size_t done = 0;
+    while (data && done < size) {
+        ssize_t got = read(fd, data + done, size - done);
+        if (got <= 0) {
+            data = NULL;
+            break;
+        }
+        done += (size_t)got;
+    }
+    close(fd);
+
+    if (!data) return false;
+
+    data[size] = '\0';
+    *code = data;
+    *length = size;
+    return true;
+}
+
+// ==================== lifecycle ====================
+
+FunctionCache* function_cache_open(const char* dir) {
+    if (!dir) return NULL;
+
+    if (mkdir(dir, 0755) != 0 && errno != EEXIST) {
+        return NULL;
+    }
+
+    FunctionCache* cache = malloc(sizeof(FunctionCache));
+    if (!cache) return NULL;
+
+    cache->dir = strdup(dir);
+    if (!cache->dir) {
+        free(cache);
+        return NULL;
+    }
+
+    // "dir/" and "dir" name the same place
+    size_t len = strlen(cache->dir);
+    while (len > 1 && cache->dir[len - 1] == '/') {
+        cache->dir[--len] = '\0';
+    }
+
+    cache->hits = 0;
+    cache->misses = 0;
+    return cache;
+}
+
+void function_cache_close(FunctionCache* cache) {
+    if (!cache) return;
+
+    free(cache->dir);
+    free(cache);
+}
+
+// ==================== lookup & store ====================
+
+void function_cache_lookup_program(FunctionCache* cache, ASTNode* program) {
+    if (!cache || !program || program->type != NODE_PROGRAM) return;
+
+    for (ASTNode* function = program->data.program.functions; function; function = function->next) {
+        if (function->type != NODE_FUNCTION) continue;
+
+        function->data.function.cache_key = function_cache_key(function);
+        if (load_entry(cache, function->data.function.cache_key,
+                       &function->data.function.cached_code,
+                       &function->data.function.cached_length)) {
+            cache->hits++;
+        } else {
+            cache->misses++;
+        }
+    }
+}
+
+bool function_cache_store(FunctionCache* cache, uint64_t key, const char* code, size_t length) {
+    char* path = entry_path(cache, key);
+    if (!path) return false;
+
+    // write to a private temporary and rename it into place, so readers only
+    // ever see complete entries
+    size_t temp_size = strlen(path) + sizeof(".XXXXXX");
+    char* temp_path = malloc(temp_size);
+    if (!temp_path) {
+        free(path);
+        return false;
+    }
+    snprintf(temp_path, temp_size, "%s.XXXXXX", path);
+
+    bool ok = false;
+    int fd = mkstemp(temp_path);
+    if (fd >= 0) {
+        ok = true;
+        size_t done = 0;
+        while (done < length) {
+            ssize_t written = write(fd, code + done, length - done);
+            if (written < 0) {
+                ok = false;
+                break;
+            }
+            done += (size_t)written;
+        }
+        ok = close(fd) == 0 && ok;
+        // mkstemp creates 0600; entries are meant to be shared
+        ok = ok && chmod(temp_path, 0644) == 0;
+        if (!ok || rename(temp_path, path) != 0) {
+            unlink(temp_path);
+            ok = false;
+        }
+    }
+
+    free(temp_path);
+    free(path);
+    return ok;
+}
@@ -1,128 +1,127 @@
 #include "transpiler/type_registry.h"
-#include <stdlib.h>
 #include <string.h>
 
-// global type registry maps
-static Map* enum_to_mapping = NULL;     // DataType -> TypeMapping*
-static Map* token_to_mapping = NULL;    // TokenType -> TypeMapping*
-static Map* wlang_to_mapping = NULL;    // const char* -> TypeMapping*
-static Map* c_to_mapping = NULL;        // const char* -> TypeMapping*
-
-// static type mapping table
-static TypeMapping type_mappings[] = {
-    // enum_value,  token_value, w_lang_name, c_equivalent, format_spec, default_value
-    {TYPE_NUM,      NUM,         "num",       "int",        "%d",        "0"},
-    {TYPE_REAL,     REAL,        "real",      "float",      "%f",        "0.0f"},
-    {TYPE_CHR,      CHR,         "chr",       "char",       "%c",        "'\\0'"},
-    {TYPE_BOOL,     BOOL,        "bool",      "bool",       "%d",        "false"},
-    {TYPE_STR,      STR,         "str",       "char*",      "%s",        "NULL"},
-    {TYPE_ZIL,      ZIL,         "zil",       "void",       "",          ""},
+// every table below is constant: lookups by enum are direct indexing and
+// lookups by name go through a perfect hash, so nothing is built at startup.
+
+// ==================== tables ====================
+
+// indexed by DataType; types without an entry are not implemented yet
+static const TypeMapping type_mappings[] = {
+    //             enum_value,  token_value, w_lang_name, c_equivalent, format_spec, default_value
+    [TYPE_NUM]  = {TYPE_NUM,    NUM,         "num",       "int",        "%d",        "0"},
+    [TYPE_REAL] = {TYPE_REAL,   REAL,        "real",      "float",      "%f",        "0.0f"},
+    [TYPE_CHR]  = {TYPE_CHR,    CHR,         "chr",       "char",       "%c",        "'\\0'"},
+    [TYPE_BOOL] = {TYPE_BOOL,   BOOL,        "bool",      "bool",       "%d",        "false"},
+    [TYPE_STR]  = {TYPE_STR,    STR,         "str",       "char*",      "%s",        "NULL"},
+    [TYPE_ZIL]  = {TYPE_ZIL,    ZIL,         "zil",       "void",       "",          ""},
 };
 
 static const size_t num_type_mappings = sizeof(type_mappings) / sizeof(type_mappings[0]);
 
+// the type keyword tokens are contiguous, so a token indexes this by offset
+#define TYPE_TOKEN_FIRST NUM
+#define TYPE_TOKEN_LAST POD
+
+static const TypeMapping* const token_mappings[TYPE_TOKEN_LAST - TYPE_TOKEN_FIRST + 1] = {
+    [NUM - TYPE_TOKEN_FIRST]  = &type_mappings[TYPE_NUM],
+    [REAL - TYPE_TOKEN_FIRST] = &type_mappings[TYPE_REAL],
+    [CHR - TYPE_TOKEN_FIRST]  = &type_mappings[TYPE_CHR],
+    [BOOL - TYPE_TOKEN_FIRST] = &type_mappings[TYPE_BOOL],
+    [STR - TYPE_TOKEN_FIRST]  = &type_mappings[TYPE_STR],
+    [ZIL - TYPE_TOKEN_FIRST]  = &type_mappings[TYPE_ZIL],
+};
+
+// perfect hash over type names: first two characters and the length, folded
+// into 16 slots. each table has its own multiplier, chosen so that none of its
+// names share a slot; the assertions below stop the build on a collision after
+// adding a type, so pick another multiplier then.
+#define NAME_SLOTS 16
+#define NAME_SLOT(c0, c1, len, mult) (((c0) + (c1) * (mult) + (len)) & (NAME_SLOTS - 1))
+#define WLANG_NAME_MULT 2
+#define C_NAME_MULT 1
+
+// each table's names once: first two characters, length, type
+#define WLANG_TYPE_NAMES(X, mult) \
+    X('n', 'u', 3, TYPE_NUM, mult)  \
+    X('r', 'e', 4, TYPE_REAL, mult) \
+    X('c', 'h', 3, TYPE_CHR, mult)  \
+    X('b', 'o', 4, TYPE_BOOL, mult) \
+    X('s', 't', 3, TYPE_STR, mult)  \
+    X('z', 'i', 3, TYPE_ZIL, mult)
+
+#define C_TYPE_NAMES(X, mult) \
+    X('i', 'n', 3, TYPE_NUM, mult)  \
+    X('f', 'l', 5, TYPE_REAL, mult) \
+    X('c', 'h', 4, TYPE_CHR, mult)  \
+    X('b', 'o', 4, TYPE_BOOL, mult) \
+    X('c', 'h', 5, TYPE_STR, mult)  \
+    X('v', 'o', 4, TYPE_ZIL, mult)
+
+#define SLOT_ENTRY(c0, c1, len, type, mult) [NAME_SLOT(c0, c1, len, mult)] = &type_mappings[type],
+
+// one bit per name: the bits only sum to their union when no two coincide
+#define SLOT_BIT_SUM(c0, c1, len, type, mult) + (1u << NAME_SLOT(c0, c1, len, mult))
+#define SLOT_BIT_UNION(c0, c1, len, type, mult) | (1u << NAME_SLOT(c0, c1, len, mult))
+
+_Static_assert((0 WLANG_TYPE_NAMES(SLOT_BIT_SUM, WLANG_NAME_MULT)) ==
+               (0 WLANG_TYPE_NAMES(SLOT_BIT_UNION, WLANG_NAME_MULT)),
+               "two W type names share a slot; change WLANG_NAME_MULT");
+_Static_assert((0 C_TYPE_NAMES(SLOT_BIT_SUM, C_NAME_MULT)) ==
+               (0 C_TYPE_NAMES(SLOT_BIT_UNION, C_NAME_MULT)),
+               "two C type names share a slot; change C_NAME_MULT");
+
+static const TypeMapping* const wlang_slots[NAME_SLOTS] = {
+    WLANG_TYPE_NAMES(SLOT_ENTRY, WLANG_NAME_MULT)
+};
+
+static const TypeMapping* const c_slots[NAME_SLOTS] = {
+    C_TYPE_NAMES(SLOT_ENTRY, C_NAME_MULT)
+};
+
+// ==================== internal helper functions ====================
+
+static size_t name_slot(const char* name, unsigned mult) {
+    // name[1] is the terminator for one-character names, never past it
+    return NAME_SLOT((unsigned char)name[0], (unsigned char)name[1], strlen(name), mult);
+}
+
 // ==================== initialization & cleanup ====================
 
+// the tables are static; these stay so callers need not change
+
 void type_registry_init(void) {
-    // avoid double initialization
-    if (enum_to_mapping != NULL) {
-        return;
-    }
-
-    // create maps with appropriate configurations
-    MapConfig enum_config = {
-        .hash = hash_int,
-        .key_equal = key_equal_int,
-        .key_copy = NULL,           // store enum values directly
-        .value_copy = NULL,         // store pointers to static data
-        .key_free = NULL,
-        .value_free = NULL
-    };
-
-    MapConfig token_config = {
-        .hash = hash_int,
-        .key_equal = key_equal_int,
-        .key_copy = NULL,
-        .value_copy = NULL,
-        .key_free = NULL,
-        .value_free = NULL
-    };
-
-    MapConfig string_config = {
-        .hash = hash_string,
-        .key_equal = key_equal_string,
-        .key_copy = NULL,           // store pointers to static strings
-        .value_copy = NULL,         // store pointers to static data
-        .key_free = NULL,
-        .value_free = NULL
-    };
-
-    enum_to_mapping = map_create(16, enum_config);
-    token_to_mapping = map_create(16, token_config);
-    wlang_to_mapping = map_create(16, string_config);
-    c_to_mapping = map_create(16, string_config);
-
-    // populate all maps
-    for (size_t i = 0; i < num_type_mappings; i++) {
-        TypeMapping* mapping = &type_mappings[i];
-
-        map_put(enum_to_mapping,
-                (void*)(intptr_t)mapping->enum_value,
-                mapping);
-
-        map_put(token_to_mapping,
-                (void*)(intptr_t)mapping->token_value,
-                mapping);
-
-        map_put(wlang_to_mapping,
-                (void*)mapping->w_lang_name,
-                mapping);
-
-        map_put(c_to_mapping,
-                (void*)mapping->c_equivalent,
-                mapping);
-    }
 }
 
 void type_registry_cleanup(void) {
-    if (enum_to_mapping) {
-        map_destroy(enum_to_mapping);
-        enum_to_mapping = NULL;
-    }
-    if (token_to_mapping) {
-        map_destroy(token_to_mapping);
-        token_to_mapping = NULL;
-    }
-    if (wlang_to_mapping) {
-        map_destroy(wlang_to_mapping);
-        wlang_to_mapping = NULL;
-    }
-    if (c_to_mapping) {
-        map_destroy(c_to_mapping);
-        c_to_mapping = NULL;
-    }
 }
 
 // ==================== lookup functions ====================
 
 const TypeMapping* type_registry_get_by_enum(DataType type) {
-    if (!enum_to_mapping) return NULL;
-    return (const TypeMapping*)map_get(enum_to_mapping, (void*)(intptr_t)type);
+    if ((size_t)type >= num_type_mappings) return NULL;
+
+    const TypeMapping* mapping = &type_mappings[type];
+    return mapping->w_lang_name ? mapping : NULL;
 }
 
 const TypeMapping* type_registry_get_by_token(TokenType token) {
-    if (!token_to_mapping) return NULL;
-    return (const TypeMapping*)map_get(token_to_mapping, (void*)(intptr_t)token);
+    if (token < TYPE_TOKEN_FIRST || token > TYPE_TOKEN_LAST) return NULL;
+    return token_mappings[token - TYPE_TOKEN_FIRST];
 }
 
 const TypeMapping* type_registry_get_by_wlang_name(const char* name) {
-    if (!wlang_to_mapping || !name) return NULL;
-    return (const TypeMapping*)map_get(wlang_to_mapping, (void*)name);
+    if (!name || !name[0]) return NULL;
+
+    const TypeMapping* mapping = wlang_slots[name_slot(name, WLANG_NAME_MULT)];
+    return mapping && strcmp(mapping->w_lang_name, name) == 0 ? mapping : NULL;
 }
 
 const TypeMapping* type_registry_get_by_c_name(const char* name) {
-    if (!c_to_mapping || !name) return NULL;
-    return (const TypeMapping*)map_get(c_to_mapping, (void*)name);
+    if (!name || !name[0]) return NULL;
+
+    const TypeMapping* mapping = c_slots[name_slot(name, C_NAME_MULT)];
+    return mapping && strcmp(mapping->c_equivalent, name) == 0 ? mapping : NULL;
 }
 
 // ==================== convenience functions ====================